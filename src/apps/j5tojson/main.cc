@@ -1,5 +1,6 @@
 #include "j5serdes.h"
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 
@@ -8,20 +9,32 @@ using namespace J5Serdes;
 
 int main(int argc, const char* argv[])
 {
-  if (argc < 2) {
-    cerr << "Usage: " << argv[0] << " <input-file>" << endl;
-    return 1;
+  bool use_stream = false;
+  const char* input = nullptr;
+  for (int i=1; i<argc; ++i) {
+    if (strcmp(argv[i], "--stream") == 0) { use_stream = true; }
+    else if (!input) { input = argv[i]; }
   }
-
-  ifstream ifstr(argv[1]);
-  if (!ifstr) {
-    cerr << "Failed to open input file: " << argv[1] << endl;
+  if (!input) {
+    cerr << "Usage: " << argv[0] << " [--stream] <input-file>" << endl;
+    cerr << "  --stream  read the input through an ifstream instead of "
+            "mapping it into memory" << endl;
     return 1;
   }
 
   try {
-    auto json = make_json_record(ifstr);
-    write_json_text(cout, json);
+    JsonRecordPtr json;
+    if (use_stream) {
+      ifstream ifstr(input);
+      if (!ifstr) {
+        cerr << "Failed to open input file: " << input << endl;
+        return 1;
+      }
+      json = make_json_record(ifstr);
+    } else {
+      json = make_json_record_from_file(input);
+    }
+    if (json) { write_json_text(cout, json); }
     cout << endl;
   } catch (const exception& e) {
     cerr << "Error: " << e.what() << endl;
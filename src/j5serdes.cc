@@ -1,13 +1,38 @@
 #include "j5serdes.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <charconv>
+#include <cstdlib>
 #include <cstring>
 #include <deque>
-#include <functional>
-#include <iomanip>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <new>
 #include <sstream>
 #include <stack>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define J5SERDES_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace J5Serdes {
 
 using namespace std;
@@ -22,16 +47,93 @@ using namespace std;
     throw runtime_error(errss.str());    \
   }
 
-static void
-__put_spaces(ostream& os, int n)
+/* Cursor over a contiguous input buffer. It offers the subset of the istream
+ * interface used by the deserialization handlers, so the handlers can be
+ * shared by both inputs, while the helpers below get dedicated overloads that
+ * work on raw pointers rather than going through peek()/get().
+ * A partial buffer is one chunk of a longer input: the helpers throw
+ * __incomplete_input instead of failing when a token runs into its end.
+ */
+struct des_buffer_t {
+  const char* cur;
+  const char* end;
+  bool partial = false;
+  explicit operator bool() const { return true; }
+  bool eof() const { return cur == end; }
+  int  peek() const
+    { return cur != end ? static_cast<unsigned char>(*cur) : EOF; }
+  int  get()
+    { return cur != end ? static_cast<unsigned char>(*cur++) : EOF; }
+};
+
+/* Character classes of the json5 tokenizer; anything not listed starts a
+ * number, a literal or an unquoted key.
+ */
+enum : uint8_t {
+  __CC_OTHER,
+  __CC_SPACE,
+  __CC_SLASH,
+  __CC_QUOTE,
+  __CC_OBJECT_OPEN,
+  __CC_OBJECT_CLOSE,
+  __CC_ARRAY_OPEN,
+  __CC_ARRAY_CLOSE,
+  __CC_COLON,
+  __CC_COMMA
+};
+
+static const array<uint8_t, 256> __json5_char_class = []() {
+  array<uint8_t, 256> ret = { 0 };
+  for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) { ret[c] = __CC_SPACE; }
+  ret['/']  = __CC_SLASH;
+  ret['"']  = __CC_QUOTE;
+  ret['\''] = __CC_QUOTE;
+  ret['{']  = __CC_OBJECT_OPEN;
+  ret['}']  = __CC_OBJECT_CLOSE;
+  ret['[']  = __CC_ARRAY_OPEN;
+  ret[']']  = __CC_ARRAY_CLOSE;
+  ret[':']  = __CC_COLON;
+  ret[',']  = __CC_COMMA;
+  return ret;
+}();
+
+static inline bool
+__is_space(int c)
+{
+  return __json5_char_class[static_cast<unsigned char>(c)] == __CC_SPACE;
+}
+
+/* characters terminating a number or a literal */
+static inline bool
+__is_scalar_end(int c)
 {
-  for (int i=0; i<n; ++i) { os << ' '; }
+  constexpr uint32_t mask = (1u << __CC_SPACE) | (1u << __CC_COMMA) |
+                            (1u << __CC_ARRAY_CLOSE) |
+                            (1u << __CC_OBJECT_CLOSE);
+  return (mask >> __json5_char_class[static_cast<unsigned char>(c)]) & 1;
 }
 
+/* characters terminating an unquoted object key */
+static inline bool
+__is_key_end(int c)
+{
+  constexpr uint32_t mask = (1u << __CC_SPACE) | (1u << __CC_COLON) |
+                            (1u << __CC_COMMA) | (1u << __CC_OBJECT_CLOSE);
+  return (mask >> __json5_char_class[static_cast<unsigned char>(c)]) & 1;
+}
+
+struct __incomplete_input {};
+
 static void
 __skip_spaces(istream& istrm)
 {
-  while (istrm && std::isspace(istrm.peek())) { istrm.get(); }
+  while (istrm && __is_space(istrm.peek())) { istrm.get(); }
+}
+
+static void
+__skip_spaces(des_buffer_t& buf)
+{
+  while (buf.cur != buf.end && __is_space(*buf.cur)) { ++ buf.cur; }
 }
 
 /* called when one '/' is consumed from istream */
@@ -46,6 +148,7 @@ __skip_comment(istream& istrm)
   } else if (c == '*') {
     while (istrm && !istrm.eof()) {
       if (istrm.get() == '*') {
+        while (istrm.peek() == '*') { istrm.get(); }
         if (istrm.get() == '/') { break; }
       }
     }
@@ -54,6 +157,34 @@ __skip_comment(istream& istrm)
   }
 }
 
+/* called when one '/' is consumed from the buffer */
+static void
+__skip_comment(des_buffer_t& buf)
+{
+  if (buf.cur == buf.end && buf.partial) { throw __incomplete_input(); }
+  assert_msg(buf.cur != buf.end, "unexpected end of input after '/'.");
+  char c = *buf.cur++;
+  if (c == '/') {
+    const char* nl = static_cast<const char*>(
+                       memchr(buf.cur, '\n', buf.end - buf.cur));
+    if (!nl && buf.partial) { throw __incomplete_input(); }
+    buf.cur = nl ? nl + 1 : buf.end;
+  } else if (c == '*') {
+    while (true) {
+      const char* star = static_cast<const char*>(
+                           memchr(buf.cur, '*', buf.end - buf.cur));
+      if (!star || star + 1 == buf.end) {
+        if (buf.partial) { throw __incomplete_input(); }
+        buf.cur = buf.end; break;
+      }
+      buf.cur = star + 1;
+      if (*buf.cur == '/') { ++ buf.cur; break; }
+    }
+  } else {
+    assert_msg(0, "unexpected character `" << c << "' after '/'.");
+  }
+}
+
 static void
 __skip_no_parse(istream& istrm)
 {
@@ -61,7 +192,7 @@ __skip_no_parse(istream& istrm)
     char c = istrm.peek();
     if (c == '/') {
       istrm.get(); __skip_comment(istrm);
-    } else if (std::isspace(c)) {
+    } else if (__is_space(c)) {
       __skip_spaces(istrm);
     } else {
       break;
@@ -69,6 +200,21 @@ __skip_no_parse(istream& istrm)
   }
 }
 
+static void
+__skip_no_parse(des_buffer_t& buf)
+{
+  while (buf.cur != buf.end) {
+    char c = *buf.cur;
+    if (c == '/') {
+      ++ buf.cur; __skip_comment(buf);
+    } else if (__is_space(c)) {
+      __skip_spaces(buf);
+    } else {
+      break;
+    }
+  }
+}
+
 static const unordered_map<char, char> __escape_map = {
   { '\b', 'b' },
   { '\f', 'f' },
@@ -80,220 +226,942 @@ static const unordered_map<char, char> __escape_map = {
   { '"',  '"' },
   { '\'', '\'' },
 };
-static const unordered_map<char, char> __unescape_map = {
-  { 'b',  '\b' },
-  { 'f',  '\f' },
-  { 'n',  '\n' },
-  { 'r',  '\r' },
-  { 't',  '\t' },
-  { '\\', '\\' },
-  { '/',  '/' },
-  { '"',  '"' },
-  { '\'', '\'' },
+static const array<char, 256> __unescape_table = []() {
+  array<char, 256> ret = { 0 };
+  ret['b']  = '\b';
+  ret['f']  = '\f';
+  ret['n']  = '\n';
+  ret['r']  = '\r';
+  ret['t']  = '\t';
+  ret['\\'] = '\\';
+  ret['/']  = '/';
+  ret['"']  = '"';
+  ret['\''] = '\'';
+  return ret;
+}();
+
+/* value of a hexadecimal digit, 0xff for any other character */
+static const array<uint8_t, 256> __hex_digit_value = []() {
+  array<uint8_t, 256> ret;
+  ret.fill(0xff);
+  for (int i=0; i<10; ++i) { ret['0' + i] = i; }
+  for (int i=0; i<6; ++i)  { ret['a' + i] = ret['A' + i] = 10 + i; }
+  return ret;
+}();
+
+static inline void
+__append_utf8(string& ret, uint32_t cp)
+{
+  char buf[4];
+  size_t n;
+  if (cp <= 0x7f) {
+    buf[0] = static_cast<char>(cp);
+    n = 1;
+  } else if (cp <= 0x7ff) {
+    buf[0] = static_cast<char>(0xc0 | (cp >> 6));
+    buf[1] = static_cast<char>(0x80 | (cp & 0x3f));
+    n = 2;
+  } else if (cp <= 0xffff) {
+    buf[0] = static_cast<char>(0xe0 | (cp >> 12));
+    buf[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    buf[2] = static_cast<char>(0x80 | (cp & 0x3f));
+    n = 3;
+  } else {
+    buf[0] = static_cast<char>(0xf0 | (cp >> 18));
+    buf[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+    buf[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    buf[3] = static_cast<char>(0x80 | (cp & 0x3f));
+    n = 4;
+  }
+  ret.append(buf, n);
+}
+
+/* reads the four hexadecimal digits of a \u escape */
+static inline uint32_t
+__retrieve_utf16_unit(const char*& cur, const char* end)
+{
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(cur);
+  size_t avail = min<size_t>(end - cur, 4);
+  for (size_t i=0; i<avail; ++i) {
+    assert_msg(__hex_digit_value[u[i]] != 0xff,
+               "unexpected non-hexadecimal character `" << cur[i] << "'.");
+  }
+  assert_msg(avail == 4, "unexpected end of input in \\u escape sequence.");
+  cur += 4;
+  return (__hex_digit_value[u[0]] << 12) | (__hex_digit_value[u[1]] << 8) |
+         (__hex_digit_value[u[2]] << 4)  |  __hex_digit_value[u[3]];
+}
+
+/* stands in for the string an escape sequence is decoded into when it is
+ * only validated */
+struct __discarded_string {
+  void operator+=(char) {};
 };
 
-static string
-__retrieve_escaped_string(istream& istrm)
+static inline void
+__append_utf8(__discarded_string&, uint32_t) {}
+
+/* called when one '\\' is consumed from the input; appends the unescaped
+ * character(s) to ret. strict json only permits the RFC 8259 escapes.
+ */
+template <typename S>
+static void
+__retrieve_escaped_string(const char*& cur, const char* end, S& ret,
+                          bool strict = false)
 {
-  char c = static_cast<char>(istrm.get());
-  if (__unescape_map.count(c)) {
-    return string(1, __unescape_map.at(c));
-  } else if (c == '\n') {
-    return "";
-  } else if (c == '\r') {
-    char c2 = static_cast<char>(istrm.peek());
-    if (c2 == '\n') { istrm.get(); }
-    return "";
+  assert_msg(cur != end, "unexpected end of input in escape sequence.");
+  char c = *cur++;
+  char unescaped = __unescape_table[static_cast<unsigned char>(c)];
+  if (unescaped && !(strict && c == '\'')) {
+    ret += unescaped;
+  } else if (c == '\n' && !strict) {
+    return;
+  } else if (c == '\r' && !strict) {
+    if (cur != end && *cur == '\n') { ++ cur; }
+    return;
   } else if (c == 'u') {
-    char u16[5] = { 0 };
-    for (int i=0; i<4; ++i) {
-      u16[i] = static_cast<char>(istrm.get());
-      assert_msg(std::isxdigit(u16[i]),
-                 "unexpected non-hexadecimal character `" << u16[i] << "'.");
-    }
-    uint16_t u16_val = std::stoul(u16, nullptr, 16);
-    string ret;
-    if (u16_val <= 0x7f) {
-      ret += static_cast<char>(u16_val);
-    } else if (u16_val <= 0x7ff) {
-      ret += static_cast<char>(0xc0 | (u16_val >> 6));
-      ret += static_cast<char>(0x80 | (u16_val & 0x3f));
-    } else if (u16_val <= 0xd7ff || u16_val >= 0xdc00) {
-      ret += static_cast<char>(0xe0 | (u16_val >> 12));
-      ret += static_cast<char>(0x80 | ((u16_val >> 6) & 0x3f));
-      ret += static_cast<char>(0x80 | (u16_val & 0x3f));
+    uint32_t u16_val = __retrieve_utf16_unit(cur, end);
+    if (u16_val <= 0xd7ff || u16_val >= 0xdc00) {
+      __append_utf8(ret, u16_val);
     } else {
-      assert_msg(!istrm.eof() && istrm.get() == '\\',
+      assert_msg(cur != end && *cur++ == '\\',
                  "expecting a subsequent code unit after the first code unit "
                  "in the surrogate range, starting with \\u.");
-      assert_msg(!istrm.eof() && istrm.get() == 'u',
+      assert_msg(cur != end && *cur++ == 'u',
                  "expecting a subsequent code unit after the first code unit "
                  "in the surrogate range, received \\ but no u.");
-      char u16s[5] = { 0 };
-      for (int i=0; i<4; ++i) {
-        u16s[i] = static_cast<char>(istrm.get());
-        assert_msg(std::isxdigit(u16s[i]),
-                   "unexpected non-hexadecimal character `" << u16s[i] << "'.");
-      }
-      uint16_t u16s_val = std::stoul(u16s, nullptr, 16);
+      uint32_t u16s_val = __retrieve_utf16_unit(cur, end);
       assert_msg(u16s_val >= 0xdc00 && u16s_val <= 0xdfff,
                  "the second code unit, or low surrogate, should be in the "
                  "range [0xdc00, 0xdfff].");
-      uint32_t u32_val = 0x10000 + (((u16_val - 0xd800) << 10) |
-                                    (u16s_val - 0xdc00));
-      ret += static_cast<char>(0xf0 | (u32_val >> 18));
-      ret += static_cast<char>(0x80 | ((u32_val >> 12) & 0x3f));
-      ret += static_cast<char>(0x80 | ((u32_val >> 6) & 0x3f));
-      ret += static_cast<char>(0x80 | (u32_val & 0x3f));
-    }
-    return ret;
+      __append_utf8(ret, 0x10000 + (((u16_val - 0xd800) << 10) |
+                                    (u16s_val - 0xdc00)));
+    }
   } else {
     assert_msg(0, "unexpected escape sequence beginning with character `"
                   << c << "'.");
   }
-  return string();
 }
 
-string
-__retrieve_quoted_string(istream& istrm)
+/* Returns the first quote or backslash in [cur, end), or end. Strings are
+ * scanned 32 or 16 bytes at a time where the cpu allows, 8 bytes at a time
+ * otherwise.
+ */
+#ifdef J5SERDES_X86_SIMD
+__attribute__((target("sse2")))
+static const char*
+__find_string_delimiter_sse2(const char* cur, const char* end, char quote)
+{
+  const __m128i q  = _mm_set1_epi8(quote);
+  const __m128i bs = _mm_set1_epi8('\\');
+  while (end - cur >= 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+    unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, q),
+                                                   _mm_cmpeq_epi8(x, bs)));
+    if (mask) { return cur + __builtin_ctz(mask); }
+    cur += 16;
+  }
+  while (cur != end && *cur != quote && *cur != '\\') { ++ cur; }
+  return cur;
+}
+
+__attribute__((target("avx2")))
+static const char*
+__find_string_delimiter_avx2(const char* cur, const char* end, char quote)
+{
+  const __m256i q  = _mm256_set1_epi8(quote);
+  const __m256i bs = _mm256_set1_epi8('\\');
+  while (end - cur >= 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur));
+    unsigned mask = _mm256_movemask_epi8(
+                      _mm256_or_si256(_mm256_cmpeq_epi8(x, q),
+                                      _mm256_cmpeq_epi8(x, bs)));
+    if (mask) { return cur + __builtin_ctz(mask); }
+    cur += 32;
+  }
+  return __find_string_delimiter_sse2(cur, end, quote);
+}
+
+static const char*
+__find_string_delimiter(const char* cur, const char* end, char quote)
+{
+  static const bool has_avx2 = (__builtin_cpu_init(),
+                                __builtin_cpu_supports("avx2"));
+  return has_avx2 ? __find_string_delimiter_avx2(cur, end, quote)
+                  : __find_string_delimiter_sse2(cur, end, quote);
+}
+#else
+static const char*
+__find_string_delimiter(const char* cur, const char* end, char quote)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  const uint64_t ones = 0x0101010101010101ull;
+  const uint64_t highs = 0x8080808080808080ull;
+  const uint64_t q = ones * static_cast<unsigned char>(quote);
+  const uint64_t bs = ones * static_cast<unsigned char>('\\');
+  while (end - cur >= 8) {
+    uint64_t w;
+    memcpy(&w, cur, 8);
+    uint64_t xq = w ^ q, xb = w ^ bs;
+    uint64_t hit = (((xq - ones) & ~xq) | ((xb - ones) & ~xb)) & highs;
+    if (hit) { return cur + (__builtin_ctzll(hit) >> 3); }
+    cur += 8;
+  }
+#endif
+  while (cur != end && *cur != quote && *cur != '\\') { ++ cur; }
+  return cur;
+}
+#endif
+
+/* Appends the unescaped content of [begin, end), which holds no unescaped
+ * closing quote, to ret.
+ */
+static void
+__unescape_string(const char* begin, const char* end, string& ret,
+                  bool strict = false)
+{
+  while (begin != end) {
+    const char* bs = static_cast<const char*>(memchr(begin, '\\',
+                                                     end - begin));
+    if (!bs) { ret.append(begin, end); break; }
+    ret.append(begin, bs);
+    begin = bs + 1;
+    __retrieve_escaped_string(begin, end, ret, strict);
+  }
+}
+
+/* The raw content is pulled with getline(), which moves whole runs out of
+ * the stream buffer; a quote preceded by an odd run of backslashes is
+ * escaped and does not close the string. The decoded string is left in
+ * scratch.
+ */
+static string_view
+__retrieve_quoted_string(istream& istrm, string& scratch)
 {
   char open_quote = istrm.get();
   assert_msg(open_quote == '"' || open_quote == '\'',
              "unexpected openquote character `" << open_quote << "'.");
-  string ret;
+  string raw, run;
   bool closed = false;
-  while (istrm && !istrm.eof()) {
-    char c = istrm.get();
-    if (c == '\\') {
-      ret += __retrieve_escaped_string(istrm);
-    } else if (c == open_quote) {
-      closed = true; break;
-    } else {
-      ret += c;
-    }
+  while (getline(istrm, run, open_quote)) {
+    raw += run;
+    if (istrm.eof()) { break; }
+    size_t n_bs = 0;
+    while (n_bs < raw.size() && raw[raw.size() - 1 - n_bs] == '\\')
+    { ++ n_bs; }
+    if (n_bs % 2 == 0) { closed = true; break; }
+    raw += open_quote;
   }
   assert_msg(closed, "missing closing quote character `" << open_quote << "'.");
+  scratch.clear();
+  __unescape_string(raw.data(), raw.data() + raw.size(), scratch);
+  return scratch;
+}
+
+/* Clean runs between escape sequences are located with vector compares and
+ * appended in one go. A string without escape sequences is returned as a
+ * view into the buffer, otherwise it is decoded into scratch.
+ */
+static string_view
+__retrieve_quoted_string(des_buffer_t& buf, string& scratch)
+{
+  char open_quote = static_cast<char>(buf.get());
+  assert_msg(open_quote == '"' || open_quote == '\'',
+             "unexpected openquote character `" << open_quote << "'.");
+  const char* begin = buf.cur;
+  const char* delim = __find_string_delimiter(buf.cur, buf.end, open_quote);
+  if (delim != buf.end && *delim == open_quote) {
+    buf.cur = delim + 1;
+    return string_view(begin, delim - begin);
+  }
+  scratch.clear();
+  while (buf.cur != buf.end) {
+    delim = __find_string_delimiter(buf.cur, buf.end, open_quote);
+    scratch.append(buf.cur, delim);
+    buf.cur = delim;
+    if (delim == buf.end) { break; }
+    ++ buf.cur;
+    if (*delim == open_quote) { return scratch; }
+    /* the longest escape sequence is a \u surrogate pair */
+    if (buf.partial && buf.end - buf.cur < 11) { break; }
+    __retrieve_escaped_string(buf.cur, buf.end, scratch);
+  }
+  if (buf.partial) { throw __incomplete_input(); }
+  assert_msg(0, "missing closing quote character `" << open_quote << "'.");
+  return scratch;
+}
+
+/* unquoted object keys, as permitted by json5 */
+static string_view
+__retrieve_unquoted_key(istream& istrm, string& scratch)
+{
+  scratch.clear();
+  while (istrm && !istrm.eof()) {
+    int c = istrm.peek();
+    if (c == EOF || __is_key_end(c)) { break; }
+    scratch += static_cast<char>(istrm.get());
+  }
+  return scratch;
+}
+
+static string_view
+__retrieve_unquoted_key(des_buffer_t& buf, string& scratch)
+{
+  const char* begin = buf.cur;
+  while (buf.cur != buf.end && !__is_key_end(*buf.cur)) { ++ buf.cur; }
+  if (buf.cur == buf.end && buf.partial) { throw __incomplete_input(); }
+  return string_view(begin, buf.cur - begin);
+}
+
+/* the escape of each character written escaped, 0 for the others */
+static const array<char, 256> __escape_table = []() {
+  array<char, 256> ret = { 0 };
+  for (const auto& entry : __escape_map) {
+    if (entry.first != '\'') { ret[entry.first & 0xff] = entry.second; }
+  }
   return ret;
+}();
+
+/* Output of the serializers. The text is gathered in a buffer, which the
+ * stream receives in blocks of BLOCK_SIZE bytes and is never asked to flush.
+ * Line breaks and indentation are left out of compact output.
+ */
+class __text_sink {
+public:
+  __text_sink(ostream& os, const s_config_t& cfg)
+    : _os(os), _compact(cfg.compact), _used(0) {};
+  __text_sink(const __text_sink&) = delete;
+
+  void put(char c)
+  {
+    if (_used == BLOCK_SIZE) { flush(); }
+    _buf[_used ++] = c;
+  };
+  void put(string_view sv);
+  void put_escaped(string_view sv);
+  void put_int(int64_t value);
+  void put_double(double value);
+  /* the key of a member, and what separates it from its value */
+  void put_key(string_view key);
+  void line_break() { if (!_compact) { put('\n'); } };
+  void indent(int width);
+
+  void flush() { _os.write(_buf, _used); _used = 0; };
+
+private:
+  static constexpr size_t BLOCK_SIZE = 1 << 14;
+
+  ostream& _os;
+  bool     _compact;
+  size_t   _used;
+  char     _buf[BLOCK_SIZE];
+};
+
+void
+__text_sink::put(string_view sv)
+{
+  if (sv.size() > BLOCK_SIZE - _used) {
+    flush();
+    if (sv.size() >= BLOCK_SIZE) { _os.write(sv.data(), sv.size()); return; }
+  }
+  memcpy(_buf + _used, sv.data(), sv.size());
+  _used += sv.size();
 }
 
-string
-__escape_string(string_view sv, bool in_sq = false)
-{
-  string ret;
-  for (char c : sv) {
-    if (in_sq && c == '"') {
-      ret += c;
-    } else if (!in_sq && c == '\'') {
-      ret += c;
-    } else if (__escape_map.count(c)) {
-      ret += '\\';
-      ret += __escape_map.at(c);
-    } else {
-      ret += c;
+/* the runs between the characters to escape are copied as they are */
+void
+__text_sink::put_escaped(string_view sv)
+{
+  size_t begin = 0;
+  for (size_t i=0; i<sv.size(); ++i) {
+    char escape = __escape_table[sv[i] & 0xff];
+    if (!escape) { continue; }
+    put(sv.substr(begin, i - begin));
+    put('\\');
+    put(escape);
+    begin = i + 1;
+  }
+  put(sv.substr(begin));
+}
+
+void
+__text_sink::put_int(int64_t value)
+{
+  char text[24];
+  char* end = to_chars(text, text + sizeof(text), value).ptr;
+  put(string_view(text, end - text));
+}
+
+/* as streams write it with defaultfloat and setprecision(10) */
+void
+__text_sink::put_double(double value)
+{
+  char text[32];
+  char* end = to_chars(text, text + sizeof(text), value,
+                       chars_format::general, 10).ptr;
+  put(string_view(text, end - text));
+}
+
+void
+__text_sink::put_key(string_view key)
+{
+  put('"');
+  put(key);
+  put(_compact ? string_view("\":") : string_view("\" : "));
+}
+
+void
+__text_sink::indent(int width)
+{
+  static const char spaces[] = "                                "
+                               "                                ";
+  if (_compact) { return; }
+  for (; width > 0; width -= sizeof(spaces) - 1) {
+    put(string_view(spaces, min<size_t>(width, sizeof(spaces) - 1)));
+  }
+}
+
+/* Read-only view of a whole file. Regular files are mapped into memory;
+ * pipes, character devices and files that report no size (procfs) are read
+ * into a private buffer instead.
+ */
+class __file_view {
+public:
+  explicit __file_view(const string& path);
+  __file_view(const __file_view&) = delete;
+  ~__file_view();
+
+  string_view view() const
+    { return _map ? string_view(static_cast<const char*>(_map), _map_size)
+                  : string_view(_buf); };
+
+private:
+  void*  _map;
+  size_t _map_size;
+  string _buf;
+};
+
+#ifndef _WIN32
+__file_view::__file_view(const string& path)
+  : _map(nullptr), _map_size(0)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  assert_msg(fd >= 0, "failed to open `" << path << "': " << strerror(errno));
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      _map = addr;
+      _map_size = st.st_size;
+      ::close(fd);
+      return;
+    }
+  }
+  const size_t block_size = 1 << 16;
+  while (true) {
+    size_t size = _buf.size();
+    _buf.resize(size + block_size);
+    ssize_t n = ::read(fd, &_buf[size], block_size);
+    if (n < 0 && errno == EINTR) { _buf.resize(size); continue; }
+    _buf.resize(size + (n > 0 ? n : 0));
+    if (n < 0) {
+      int err = errno;
+      ::close(fd);
+      assert_msg(0, "failed to read `" << path << "': " << strerror(err));
     }
+    if (n == 0) { break; }
+  }
+  ::close(fd);
+}
+
+__file_view::~__file_view()
+{
+  if (_map) { ::munmap(_map, _map_size); }
+}
+#else
+__file_view::__file_view(const string& path)
+  : _map(nullptr), _map_size(0)
+{
+  ifstream ifstr(path, ios::binary);
+  assert_msg(ifstr, "failed to open `" << path << "'.");
+  stringstream ss;
+  ss << ifstr.rdbuf();
+  _buf = ss.str();
+}
+
+__file_view::~__file_view()
+{
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// record storage
+//
+// Records are allocated from the heap, one at a time. Those of a JsonDocument
+// are of classes of their own, allocated from arenas of the document, along
+// with the bodies of its arrays and objects: deleting one of them only
+// destroys it, and the document frees its arenas a block at a time.
+
+class __arena {
+public:
+  __arena() = default;
+  __arena(const __arena&) = delete;
+  ~__arena() { for (block_t& block : _blocks) { free(block.data); } };
+
+  void* allocate(size_t size);
+
+private:
+  static constexpr size_t MIN_BLOCK_SIZE = 1 << 16;
+  static constexpr size_t MAX_BLOCK_SIZE = 1 << 24;
+
+  struct block_t {
+    char*  data;
+    size_t used;
+    size_t capacity;
+  };
+  vector<block_t> _blocks;
+};
+
+void*
+__arena::allocate(size_t size)
+{
+  /* everything is 8-byte aligned */
+  size = (size + 7) & ~size_t(7);
+  if (_blocks.empty() || _blocks.back().capacity - _blocks.back().used < size) {
+    size_t capacity = _blocks.empty() ? MIN_BLOCK_SIZE
+                        : min(2 * _blocks.back().capacity, MAX_BLOCK_SIZE);
+    capacity = max(capacity, size);
+    char* data = static_cast<char*>(malloc(capacity));
+    if (!data) { throw bad_alloc(); }
+    _blocks.push_back({ data, 0, capacity });
   }
+  block_t& block = _blocks.back();
+  void* ret = block.data + block.used;
+  block.used += size;
   return ret;
 }
 
+/* allocation functions of the records of the heap */
+struct __record_storage {
+  static void* operator new(size_t size)
+  {
+    void* p = malloc(size);
+    if (!p) { throw bad_alloc(); }
+    return p;
+  }
+  static void operator delete(void* p) { free(p); }
+};
+
+/* A record of a JsonDocument, allocated from one of its arenas, see
+ * __new_arena_record().
+ */
+template <typename T>
+class __arena_record final : public T {
+public:
+  using T::T;
+
+  static void* operator new(size_t size, __arena& arena)
+    { return arena.allocate(size); }
+  static void operator delete(void*) {}
+  static void operator delete(void*, __arena&) {}
+
+private:
+  /* see JsonObjectImpl::in_arena() */
+  bool in_arena() const { return true; };
+};
+
+/* Allocates a record of type T from arena, arrays and objects taking it for
+ * their body as well.
+ */
+template <typename T, typename... Args>
+static T*
+__new_arena_record(__arena& arena, Args&&... args)
+{
+  if constexpr (is_constructible<T, __arena&>::value) {
+    return new (arena) __arena_record<T>(arena);
+  } else {
+    return new (arena) __arena_record<T>(forward<Args>(args)...);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // implementation class declarations
 
-class JsonObjectImpl final : public JsonObject {
+/* Unparsed text of a record of a lazy document; input keeps the document
+ * alive as long as a record refers to it. The records of lazy documents are
+ * of classes of their own, which parse their text on first access, see
+ * JsonLazyObjectImpl.
+ */
+struct __lazy_text {
+  shared_ptr<const void> input;
+  const char* begin;
+  const char* end;
+};
+
+/* Lazy records are parsed under one of a few locks picked by address. */
+static inline mutex&
+__lazy_mutex(const void* record)
+{
+  static mutex locks[64];
+  return locks[reinterpret_cast<uintptr_t>(record) / 64 % 64];
+}
+
+/* Runs load() on the first access to a lazy scalar; the threads waiting on
+ * the lock then find it loaded. The flag is only set once done, so that the
+ * other threads never see the value half decoded.
+ */
+template <typename F>
+static void
+__load_once(const void* record, const atomic<bool>& loaded, F&& load)
+{
+  if (loaded.load(memory_order_acquire)) { return; }
+  lock_guard<mutex> lock(__lazy_mutex(record));
+  if (loaded.load(memory_order_relaxed)) { return; }
+  load();
+  const_cast<atomic<bool>&>(loaded).store(true, memory_order_release);
+}
+
+/* The state of a body of an object or array, see JsonObjectImpl::body_t:
+ * its owners are the records sharing it, and the bodies retiring it. A body
+ * is pinned only while it has a single owner, which keeps it for good.
+ */
+struct __body_state {
+  static constexpr size_t PINNED = 1;
+  static constexpr size_t ARENA  = 2;
+  static constexpr size_t OWNER  = 4;
+
+  /* OWNER for each owner, plus PINNED, plus ARENA for a body allocated from
+   * an arena, see __new_arena_body() */
+  mutable atomic<size_t> state{ OWNER };
+
+  bool pinned() const { return state.load(memory_order_acquire) & PINNED; };
+  bool shared() const
+    { return state.load(memory_order_acquire) >= 2 * OWNER; };
+  /* adds an owner, unless the body is pinned */
+  bool try_share() const
+  {
+    size_t s = state.load(memory_order_relaxed);
+    do {
+      if (s & PINNED) { return false; }
+    } while (!state.compare_exchange_weak(s, s + OWNER,
+                                          memory_order_relaxed));
+    return true;
+  };
+  /* pins the body, unless it has other owners */
+  bool try_pin() const
+  {
+    size_t s = OWNER | (state.load(memory_order_relaxed) & ARENA);
+    return state.compare_exchange_strong(s, s | PINNED, memory_order_acq_rel)
+             || (s & PINNED);
+  };
+  /* pins a body of a single owner, which no other thread accesses */
+  void pin() const
+  {
+    if (!(state.load(memory_order_relaxed) & PINNED)) {
+      state.fetch_or(PINNED, memory_order_relaxed);
+    }
+  };
+  /* true once the last owner let go of the body */
+  bool unref() const
+    { return state.fetch_sub(OWNER, memory_order_acq_rel) < 2 * OWNER; };
+};
+
+/* A body of an array or object of a JsonDocument, allocated from one of its
+ * arenas.
+ */
+template <typename B>
+static B*
+__new_arena_body(__arena& arena)
+{
+  B* b = new (arena.allocate(sizeof(B))) B();
+  b->state.store(__body_state::OWNER | __body_state::ARENA,
+                 memory_order_relaxed);
+  return b;
+}
+
+/* deletes b, or only destroys it if it was allocated from an arena */
+template <typename B>
+static void
+__delete_body(B* b)
+{
+  if (b->state.load(memory_order_relaxed) & __body_state::ARENA) { b->~B(); }
+  else { delete b; }
+}
+
+/* Owns a body as one of its owners. Read atomically, as a const access
+ * replaces the body it still shares, which other threads may be reading,
+ * see JsonObjectImpl::unshare().
+ */
+template <typename B>
+class __body_ptr {
+public:
+  __body_ptr(B* p = nullptr) noexcept : _p(p) {};
+  __body_ptr(__body_ptr&& src) noexcept : _p(src.release()) {};
+  __body_ptr& operator=(__body_ptr&& src) noexcept
+    { reset(src.release()); return *this; };
+  ~__body_ptr() { reset(); };
+
+  explicit operator bool() const { return get() != nullptr; };
+  B* operator->() const { return get(); };
+  B& operator*() const { return *get(); };
+  B* get() const { return _p.load(memory_order_acquire); };
+
+  B* release() noexcept { return _p.exchange(nullptr, memory_order_acq_rel); };
+  void reset(B* p = nullptr) noexcept
+  {
+    B* old = _p.exchange(p, memory_order_acq_rel);
+    if (old && old->unref()) { __delete_body(old); }
+  };
+  /* Takes p from a const access. The body held so far, if any, is retired
+   * by p, as other threads may still be reading it.
+   */
+  void replace(__body_ptr&& p) const
+  {
+    p->retired._p.store(_p.load(memory_order_relaxed), memory_order_relaxed);
+    _p.store(p.release(), memory_order_release);
+  };
+
+private:
+  mutable atomic<B*> _p;
+};
+
+/* the body of the records let go of theirs, pinned so as to be never shared */
+template <typename B>
+static const B&
+__empty_body()
+{
+  static const B* empty = []() { B* b = new B(); b->pin(); return b; }();
+  return *empty;
+}
+
+/* Const accesses which unshare a body take one of these locks. */
+static inline mutex&
+__unshare_mutex(const void* record)
+{
+  static mutex locks[64];
+  return locks[reinterpret_cast<uintptr_t>(record) / 64 % 64];
+}
+
+class JsonObjectImpl
+  : public JsonObject,
+    public __record_storage {
 public:
-  JsonObjectImpl() {};
+  JsonObjectImpl() : _body(new body_t()) {};
+  /* an object of a JsonDocument, whose body is allocated from arena */
+  explicit JsonObjectImpl(__arena& arena)
+    : _body(__new_arena_body<body_t>(arena)) {};
   JsonObjectImpl(const JsonObjectImpl&);
-  JsonObjectImpl(JsonObjectImpl&&) noexcept;
+  /* parses a lazy src first */
+  JsonObjectImpl(JsonObjectImpl&&);
   ~JsonObjectImpl() noexcept;
   JsonObject& operator=(const JsonObject&);
   JsonObject& operator=(JsonObject&&);
 
   void unlink_child_records(deque<JsonRecord*>&);
 
+  /* inserts like insert(), for builders which keep no handle on v; false
+   * if key is already present, v then being left untouched */
+  bool append(string_view key, JsonRecordPtr&& v);
+
+  /* the members, for traversals of the library which hand out no handle on
+   * them, and so leave them shared with the clones */
+  const list<value_type>& members() const { return body().data; };
+
 private:
   JsonRecordPtr        clone() const;
 
   pair<iterator, bool> insert(value_type&&);
   pair<iterator, bool> insert(string_view, JsonRecordPtr&&);
   pair<iterator, bool> insert(string_view, const JsonRecordPtr&);
+  pair<iterator, bool> try_emplace(string&& key, JsonRecordPtr&&);
+  pair<iterator, bool> try_emplace(string&& key, JsonRecord::Type);
 
-  iterator             find(const string& key);
-  const_iterator       find(const string& key) const;
+  iterator             find(string_view key);
+  const_iterator       find(string_view key) const;
+  iterator             find(const JsonKey& key);
+  const_iterator       find(const JsonKey& key) const;
 
-  JsonRecordPtr&       at(const string& key);
-  const JsonRecord*    at(const string& key) const;
+  JsonRecordPtr&       at(string_view key);
+  const JsonRecord*    at(string_view key) const;
+  JsonRecordPtr&       at(const JsonKey& key);
+  const JsonRecord*    at(const JsonKey& key) const;
 
   iterator             erase(const_iterator);
-  size_t               erase(const string& key);
+  size_t               erase(string_view key);
 
-  iterator             begin() { return _data.begin(); };
-  const_iterator       begin() const { return _data.begin(); };
-  iterator             end() { return _data.end(); };
-  const_iterator       end() const { return _data.end(); };
+  iterator             begin() { return pin().data.begin(); };
+  const_iterator       begin() const { return pinned_body().data.begin(); };
+  iterator             end() { return pin().data.end(); };
+  const_iterator       end() const { return pinned_body().data.end(); };
 
-  void                 clear() { _data.clear(); _map.clear(); };
+  void                 clear();
 
-  size_t               count(const string& key) const
-                         { return _map.count(key); };
-  bool                 empty() const { return _data.empty(); };
-  size_t               size() const { return _data.size(); };
+  size_t               count(string_view key) const;
+  size_t               count(const JsonKey& key) const;
+  bool                 empty() const { return body().data.empty(); };
+  size_t               size() const { return body().data.size(); };
 
-  JsonRecordPtr&       operator[](const string& key);
+  JsonRecordPtr&       operator[](string_view key);
 
   JsonObject&          as_object() { return *this; };
   const JsonObject&    as_object() const { return *this; };
 
-private:
-  list<value_type> _data;
-  unordered_map<string, list<value_type>::iterator> _map;
+protected:
+  /* Members are found with an index in objects of INDEX_THRESHOLD members
+   * or more, and by a linear scan in smaller ones, which need no memory
+   * beyond the list.
+   */
+  static constexpr size_t INDEX_THRESHOLD = 16;
+
+  struct index_slot_t {
+    size_t   hash;  /* 0 in empty slots */
+    iterator it;
+  };
+
+  /* The members, shared by an object and its clones until one of them is
+   * modified, or hands out a member by reference, pointer or iterator,
+   * const ones included: it then copies the list for itself. A body is
+   * pinned once a member was handed out, or placed by the caller, who may
+   * still modify it: it is never shared again, and its clones copy the list
+   * at once.
+   */
+  struct body_t : __body_state {
+    list<value_type>     data;
+    /* Open addressing with linear probing, over a power of two slots at
+     * most half full; empty until the object first reaches INDEX_THRESHOLD
+     * members. The iterators stay valid as the list never moves its nodes.
+     */
+    vector<index_slot_t> index;
+    /* the body replaced by a const access, kept for the threads still
+     * reading it until the object is next modified */
+    __body_ptr<body_t>   retired;
+  };
+
+  /* an object with no body yet, see load_body() */
+  explicit JsonObjectImpl(body_t* body) : _body(body) {};
+
+  /* The body of an object which has none: that of a lazy object, parsed on
+   * first access, or none for an object moved from.
+   */
+  virtual const body_t* load_body() const { return nullptr; };
+  /* whether this is an object of a JsonDocument, see __arena_record */
+  virtual bool         in_arena() const { return false; };
+  const body_t&        body() const;
+  /* the body, pinned as a member is handed out by const access */
+  const body_t&        pinned_body() const
+    { const body_t& b = body(); return b.pinned() ? b : unshare(); };
+  const body_t&        unshare() const;
+  /* the body, copied first if shared */
+  body_t&              own();
+  body_t&              pin() { body_t& b = own(); b.pin(); return b; };
+  /* the body for a copy of this object */
+  __body_ptr<body_t>   share() const;
+  /* the members cloned, sharing their own bodies */
+  static __body_ptr<body_t> copy_body(const body_t&);
+
+  /* hash is that of key, or 0 to have it computed if needed */
+  iterator             locate(string_view key, size_t hash = 0) const
+                         { return locate(body(), key, hash); };
+  static iterator      locate(const body_t&, string_view key, size_t hash);
+  /* Looks key up, hashing it once, and appends a member with the record
+   * returned by make() if it is not found.
+   */
+  template <typename K, typename F>
+  static pair<iterator, bool> emplace_member(body_t&, K&& key, F&& make);
+  static void          build_index(body_t&);
+  static void          index_member(body_t&, iterator, size_t hash = 0);
+  static void          unindex_member(body_t&, const_iterator);
+
+  __body_ptr<body_t>   _body;
 };
 
-class JsonArrayImpl final : public JsonArray {
+class JsonArrayImpl
+  : public JsonArray,
+    public __record_storage {
 public:
-  JsonArrayImpl() {};
+  JsonArrayImpl() : _body(new body_t()) {};
+  explicit JsonArrayImpl(__arena& arena)
+    : _body(__new_arena_body<body_t>(arena)) {};
   JsonArrayImpl(const JsonArrayImpl&);
-  JsonArrayImpl(JsonArrayImpl&&) noexcept;
+  JsonArrayImpl(JsonArrayImpl&&);
   JsonArray& operator=(const JsonArray&);
   JsonArray& operator=(JsonArray&&);
   ~JsonArrayImpl() noexcept;
 
   void unlink_child_records(deque<JsonRecord*>&);
 
+  /* moves the elements of the arrays to the end of this one */
+  void splice(vector<JsonArrayImpl*>&);
+
+  /* pushes like push_back(), for builders which keep no handle on v */
+  void append(JsonRecordPtr&& v) { own().data.push_back(std::move(v)); };
+
+  /* the elements, see JsonObjectImpl::members() */
+  const vector<JsonRecordPtr>& elements() const { return body().data; };
+
 private:
   JsonRecordPtr     clone() const;
 
   void              push_back(JsonRecordPtr&&);
   void              push_back(const JsonRecordPtr&);
+  JsonRecordPtr&    emplace_back(JsonRecord::Type);
 
-  iterator          begin()       { return _data.begin(); };
-  const_iterator    begin() const { return _data.begin(); };
-  iterator          end()         { return _data.end(); };
-  const_iterator    end() const   { return _data.end(); };
+  iterator          begin()       { return pin().data.begin(); };
+  const_iterator    begin() const { return pinned_body().data.begin(); };
+  iterator          end()         { return pin().data.end(); };
+  const_iterator    end() const   { return pinned_body().data.end(); };
 
-  JsonRecordPtr&    at(size_t i)       { return _data.at(i); };
-  const JsonRecord* at(size_t i) const { return _data.at(i).get(); };
+  JsonRecordPtr&    at(size_t i)       { return pin().data.at(i); };
+  const JsonRecord* at(size_t i) const
+                      { return pinned_body().data.at(i).get(); };
 
-  void              clear()       { _data.clear(); };
+  void              clear();
 
-  bool              empty() const { return _data.empty(); };
-  size_t            size() const  { return _data.size();  };
+  bool              empty() const { return body().data.empty(); };
+  size_t            size() const  { return body().data.size();  };
 
-  JsonRecordPtr&    operator[](size_t i)       { return _data.at(i); };
-  const JsonRecord* operator[](size_t i) const { return _data.at(i).get(); };
+  JsonRecordPtr&    operator[](size_t i)       { return pin().data.at(i); };
+  const JsonRecord* operator[](size_t i) const
+                      { return pinned_body().data.at(i).get(); };
 
   JsonArray&        as_array()       { return *this; };
   const JsonArray&  as_array() const { return *this; };
 
-private:
-  vector<JsonRecordPtr> _data;
+protected:
+  /* the elements, shared and pinned like the members of objects */
+  struct body_t : __body_state {
+    vector<JsonRecordPtr> data;
+    __body_ptr<body_t>    retired;
+  };
+
+  explicit JsonArrayImpl(body_t* body) : _body(body) {};
+
+  /* see JsonObjectImpl::load_body() */
+  virtual const body_t* load_body() const { return nullptr; };
+  virtual bool         in_arena() const { return false; };
+  const body_t&        body() const;
+  const body_t&        pinned_body() const
+    { const body_t& b = body(); return b.pinned() ? b : unshare(); };
+  const body_t&        unshare() const;
+  body_t&              own();
+  body_t&              pin() { body_t& b = own(); b.pin(); return b; };
+  __body_ptr<body_t>   share() const;
+  static __body_ptr<body_t> copy_body(const body_t&);
+
+  __body_ptr<body_t>   _body;
 };
 
-class JsonDataImpl final : public JsonData {
+class JsonDataImpl
+  : public JsonData,
+    public __record_storage {
 public:
   enum class NativeType : uint8_t {
     NONE = 0,
     FLOAT = 1,
     INT = 2,
     BOOL = 3,
+    LAZY = 4,  /* a JsonLazyDataImpl, for its whole life */
   };
   JsonDataImpl() : _native_type(NativeType::NONE) {
     _content.l = 0;
@@ -322,11 +1190,18 @@ public:
   JsonData& operator=(JsonData&&) noexcept;
   ~JsonDataImpl() noexcept;
 
-  friend JsonRecordPtr make_json_scalar(istream&, const d_config_t&);
-  friend void          write_json_data_text(ostream&, const JsonData*,
-                                            const s_config_t&);
+  friend void          write_json_data_text(__text_sink&, const JsonData*);
+  friend class         JsonLazyDataImpl;
+
+protected:
+  explicit JsonDataImpl(NativeType type) : _native_type(type) {
+    _content.l = 0;
+  };
 
 private:
+  /* the value of a JsonLazyDataImpl, decoded on first access */
+  const JsonDataImpl& lazy_value() const;
+
   JsonRecordPtr      clone() const;
 
   bool               as_bool() const;
@@ -347,21 +1222,20 @@ private:
   NativeType _native_type;
 };
 
-class JsonStringImpl final : public JsonString {
+class JsonStringImpl
+  : public JsonString,
+    public __record_storage {
 public:
   JsonStringImpl() = default;
   JsonStringImpl(string_view value) : _content(value) {};
+  JsonStringImpl(string&& value) : _content(std::move(value)) {};
   JsonStringImpl(const JsonStringImpl&);
   JsonStringImpl(JsonStringImpl&&) noexcept;
   JsonString& operator=(const JsonString&);
   JsonString& operator=(JsonString&&) noexcept;
   ~JsonStringImpl() noexcept;
 
-  friend JsonRecordPtr make_json_scalar(istream&, const d_config_t&);
-  friend void          write_json_string_text(ostream&, const JsonString*,
-                                              const s_config_t&);
-
-private:
+protected:
   JsonRecordPtr      clone() const;
 
   bool               as_bool() const;
@@ -374,56 +1248,181 @@ private:
   JsonString&        as_string() { return *this; };
   const JsonString&  as_string() const { return *this; };
 
-private:
   string _content;
 };
 
-////////////////////////////////////////////////////////////////////////////////
+/* A string value held by a string pool, see JsonStringPoolImpl: a record of
+ * its own, so that the other strings make no room for the pointer.
+ */
+class JsonPooledStringImpl
+  : public JsonString,
+    public __record_storage {
+public:
+  explicit JsonPooledStringImpl(shared_ptr<const string>&& value)
+    : _value(std::move(value)) {};
 
-JsonObjectImpl::JsonObjectImpl(const JsonObjectImpl& src)
-{
-  for (auto& entry : src._data) {
-    _data.push_back({ entry.first, entry.second->clone() });
-    _map.insert({ entry.first, prev(_data.end()) });
-  }
-}
+private:
+  JsonRecordPtr      clone() const
+                       { return make_unique<JsonPooledStringImpl>(*this); };
 
-JsonObjectImpl::JsonObjectImpl(JsonObjectImpl&& src) noexcept
-  : _data(std::move(src._data))
-{
-  src._data.clear();
-  src._map.clear();
-  for (auto it=_data.begin(); it!=_data.end(); ++it) {
-    _map.insert({ it->first, it });
-  }
-}
+  bool               as_bool() const
+                       { return *_value == "true" || *_value == "True"; };
+  double             as_double() const { return stod(*_value); };
+  long long          as_int() const { return stoll(*_value); };
+  unsigned long long as_unsigned() const { return stoull(*_value); };
 
-JsonObject&
-JsonObjectImpl::operator=(const JsonObject& src)
-{
-  if (this == &src) { return *this; }
-  _map.clear();
-  _data.clear();
-  const JsonObjectImpl& src_impl = static_cast<const JsonObjectImpl&>(src);
-  for (auto& entry : src_impl._data) {
-    _data.push_back({ entry.first, entry.second->clone() });
-    _map.insert({ entry.first, prev(_data.end()) });
-  }
+  const string&      to_string() const { return *_value; };
+
+  JsonString&        as_string() { return *this; };
+  const JsonString&  as_string() const { return *this; };
+
+  shared_ptr<const string> _value;
+};
+
+/* The records of lazy documents: arrays and objects have no body until
+ * first accessed, and scalars decode their value on first access. They are
+ * otherwise the records of the classes they derive from.
+ */
+class JsonLazyObjectImpl final : public JsonObjectImpl {
+public:
+  explicit JsonLazyObjectImpl(__lazy_text&& text)
+    : JsonObjectImpl(nullptr), _text(std::move(text)) {};
+
+private:
+  JsonRecordPtr clone() const;
+  const body_t* load_body() const;
+
+  __lazy_text _text;
+};
+
+class JsonLazyArrayImpl final : public JsonArrayImpl {
+public:
+  explicit JsonLazyArrayImpl(__lazy_text&& text)
+    : JsonArrayImpl(nullptr), _text(std::move(text)) {};
+
+private:
+  JsonRecordPtr clone() const;
+  const body_t* load_body() const;
+
+  __lazy_text _text;
+};
+
+class JsonLazyDataImpl final : public JsonDataImpl {
+public:
+  explicit JsonLazyDataImpl(__lazy_text&& text)
+    : JsonDataImpl(NativeType::LAZY), _text(std::move(text)) {};
+
+  const JsonDataImpl& value() const;
+
+private:
+  JsonRecordPtr clone() const;
+
+  __lazy_text          _text;
+  mutable JsonDataImpl _value;
+  atomic<bool>         _loaded{ false };
+};
+
+class JsonLazyStringImpl final : public JsonStringImpl {
+public:
+  explicit JsonLazyStringImpl(__lazy_text&& text) : _text(std::move(text)) {};
+
+private:
+  void               load() const;
+
+  JsonRecordPtr      clone() const;
+
+  bool               as_bool() const
+                       { load(); return JsonStringImpl::as_bool(); };
+  double             as_double() const
+                       { load(); return JsonStringImpl::as_double(); };
+  long long          as_int() const
+                       { load(); return JsonStringImpl::as_int(); };
+  unsigned long long as_unsigned() const
+                       { load(); return JsonStringImpl::as_unsigned(); };
+
+  const string&      to_string() const
+                       { load(); return JsonStringImpl::to_string(); };
+
+  __lazy_text  _text;
+  atomic<bool> _loaded{ false };
+};
+
+/* Pools the string values handed to __dom_builder::on_string(); keys are
+ * copied into the members, whose value_type holds a std::string. Strings
+ * short enough to be stored inline by std::string gain nothing from
+ * sharing, and are never pooled. This is the pool of d_config_t::string_pool,
+ * which may be shared by the builders of several threads, hence the lock;
+ * see __document_string_pool for that of intern_strings.
+ */
+class JsonStringPoolImpl final : public JsonStringPool {
+public:
+  explicit JsonStringPoolImpl(size_t max_length) : _max_length(max_length) {};
+
+  /* returns nullptr for a string that is not pooled */
+  shared_ptr<const string> intern(string_view);
+
+private:
+  size_t size() const;
+  void   clear();
+
+private:
+  mutable mutex _mtx;
+  /* the keys are views of the pooled strings */
+  unordered_map<string_view, shared_ptr<const string>> _strings;
+  size_t _max_length;
+};
+
+/* The pool of d_config_t::intern_strings, which only the builder of one
+ * document uses: it takes no lock, and it is never cleared, so its strings
+ * are kept in one block of storage which the records share, rather than in
+ * an allocation of their own each.
+ */
+class __document_string_pool {
+public:
+  explicit __document_string_pool(size_t max_length)
+    : _storage(make_shared<storage_t>()), _max_length(max_length) {};
+
+  /* returns nullptr for a string that is not pooled */
+  shared_ptr<const string> intern(string_view);
+
+private:
+  struct storage_t {
+    deque<string> strings;  /* never moved as more are added */
+    unordered_map<string_view, const string*> index;
+  };
+
+  shared_ptr<storage_t> _storage;
+  size_t                _max_length;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+JsonObjectImpl::JsonObjectImpl(const JsonObjectImpl& src) : _body(src.share())
+{}
+
+JsonObjectImpl::JsonObjectImpl(JsonObjectImpl&& src)
+{
+  src.body();
+  _body = std::move(src._body);
+}
+
+JsonObject&
+JsonObjectImpl::operator=(const JsonObject& src)
+{
+  if (this == &src) { return *this; }
+  const JsonObjectImpl& src_impl = static_cast<const JsonObjectImpl&>(src);
+  /* src may be one of the members let go of */
+  _body = src_impl.share();
   return *this;
 }
 
 JsonObject&
 JsonObjectImpl::operator=(JsonObject&& src)
 {
-  _map.clear();
-  _data.clear();
   JsonObjectImpl&& src_impl = static_cast<JsonObjectImpl&&>(src);
-  _data = std::move(src_impl._data);
-  for (auto it=_data.begin(); it!=_data.end(); ++it) {
-    _map.insert({ it->first, it });
-  }
-  src_impl._data.clear();
-  src_impl._map.clear();
+  src_impl.body();
+  __body_ptr<body_t> body = std::move(src_impl._body);
+  _body = std::move(body);
   return *this;
 }
 
@@ -451,139 +1450,392 @@ JsonObjectImpl::~JsonObjectImpl() noexcept
 void
 JsonObjectImpl::unlink_child_records(deque<JsonRecord*>& ptrs)
 {
-  for (auto& entry : _data) {
+  /* the members of a shared body stay with its other owners */
+  body_t* b = _body.release();
+  if (!b || !b->unref()) { return; }
+  for (auto& entry : b->data) {
     auto ptr = entry.second.release();
     if (ptr) { ptrs.push_back(ptr); }
   }
-  _map.clear();
-  _data.clear();
+  __delete_body(b);
 }
 
 JsonRecordPtr
 JsonObjectImpl::clone() const
 {
-  JsonObjectPtr ret = make_json_object();
-  for (const auto& entry : _data) {
-    ret->insert(entry.first, entry.second->clone());
+  return make_unique<JsonObjectImpl>(*this);
+}
+
+const JsonObjectImpl::body_t&
+JsonObjectImpl::body() const
+{
+  const body_t* b = _body.get();
+  if (!b && !(b = load_body())) { return __empty_body<body_t>(); }
+  return *b;
+}
+
+/* Several threads may hand out members of this object at once, and read
+ * its body meanwhile: the body is replaced by one of them, and kept until
+ * the object is next modified.
+ */
+const JsonObjectImpl::body_t&
+JsonObjectImpl::unshare() const
+{
+  lock_guard<mutex> lock(__unshare_mutex(this));
+  const body_t* b = _body.get();
+  if (b->try_pin()) { return *b; }
+  __body_ptr<body_t> copy = copy_body(*b);
+  copy->pin();
+  _body.replace(std::move(copy));
+  return *_body;
+}
+
+JsonObjectImpl::body_t&
+JsonObjectImpl::own()
+{
+  body_t* b = _body.get();
+  if (!b) { b = const_cast<body_t*>(load_body()); }
+  if (!b) { _body.reset(b = new body_t()); }
+  else if (b->shared()) { _body = copy_body(*b); b = _body.get(); }
+  else if (b->retired) { b->retired.reset(); }
+  return *b;
+}
+
+__body_ptr<JsonObjectImpl::body_t>
+JsonObjectImpl::share() const
+{
+  const body_t& b = body();
+  /* the members of an arena go with its document */
+  if (!in_arena() && b.try_share()) {
+    return const_cast<body_t*>(&b);
+  }
+  return copy_body(b);
+}
+
+__body_ptr<JsonObjectImpl::body_t>
+JsonObjectImpl::copy_body(const body_t& src)
+{
+  __body_ptr<body_t> body(new body_t());
+  for (const auto& entry : src.data) {
+    body->data.emplace_back(entry.first,
+                            entry.second ? entry.second->clone() : nullptr);
+  }
+  if (body->data.size() >= INDEX_THRESHOLD) { build_index(*body); }
+  return body;
+}
+
+static inline size_t
+__member_hash(string_view key)
+{
+  size_t hash = std::hash<string_view>()(key);
+  return hash ? hash : 1;
+}
+
+JsonKey::JsonKey(string_view key) : _key(key), _hash(__member_hash(key))
+{}
+
+JsonObject::iterator
+JsonObjectImpl::locate(const body_t& body, string_view key, size_t hash)
+{
+  /* only modified through the iterator once owned */
+  body_t& b = const_cast<body_t&>(body);
+  if (b.index.empty()) {
+    auto it = b.data.begin();
+    for (; it != b.data.end() && it->first != key; ++ it) {}
+    return it;
+  }
+  if (!hash) { hash = __member_hash(key); }
+  size_t mask = b.index.size() - 1;
+  for (size_t i = hash & mask; b.index[i].hash; i = (i + 1) & mask) {
+    if (b.index[i].hash == hash && b.index[i].it->first == key) {
+      return b.index[i].it;
+    }
+  }
+  return b.data.end();
+}
+
+void
+JsonObjectImpl::build_index(body_t& b)
+{
+  size_t capacity = 2 * INDEX_THRESHOLD;
+  while (capacity < 4 * b.data.size()) { capacity *= 2; }
+  b.index.assign(capacity, { 0, iterator() });
+  for (auto it = b.data.begin(); it != b.data.end(); ++ it) {
+    size_t hash = __member_hash(it->first), i = hash & (capacity - 1);
+    for (; b.index[i].hash; i = (i + 1) & (capacity - 1)) {}
+    b.index[i] = { hash, it };
   }
-  return ret;
 }
 
+/* it is the last member, just appended */
+void
+JsonObjectImpl::index_member(body_t& b, iterator it, size_t hash)
+{
+  if (b.index.empty() ? b.data.size() >= INDEX_THRESHOLD
+                      : 2 * b.data.size() > b.index.size()) {
+    build_index(b);
+    return;
+  }
+  if (b.index.empty()) { return; }
+  if (!hash) { hash = __member_hash(it->first); }
+  size_t mask = b.index.size() - 1, i;
+  for (i = hash & mask; b.index[i].hash; i = (i + 1) & mask) {}
+  b.index[i] = { hash, it };
+}
+
+/* Removes the slot of it, and moves back the following slots of the probe
+ * run that may no longer be reached past the emptied one.
+ */
+void
+JsonObjectImpl::unindex_member(body_t& b, const_iterator it)
+{
+  if (b.index.empty()) { return; }
+  size_t mask = b.index.size() - 1;
+  size_t i = __member_hash(it->first) & mask;
+  for (; b.index[i].it != it; i = (i + 1) & mask) {}
+  for (size_t j = (i + 1) & mask; b.index[j].hash; j = (j + 1) & mask) {
+    size_t home = b.index[j].hash & mask;
+    /* j stays if its home slot lies cyclically in (i, j] */
+    if (i < j ? (home <= i || home > j) : (home <= i && home > j)) {
+      b.index[i] = b.index[j];
+      i = j;
+    }
+  }
+  b.index[i].hash = 0;
+}
+
+template <typename K, typename F>
 pair<JsonObject::iterator, bool>
-JsonObjectImpl::insert(value_type&& v)
+JsonObjectImpl::emplace_member(body_t& b, K&& key, F&& make)
 {
-  if (_map.count(v.first)) { return { _data.end(), false }; }
-  _data.emplace_back(std::move(v));
-  auto it = prev(_data.end());
-  _map.insert({ it->first, it });
+  /* small objects are scanned, and hash their keys only to build the index */
+  size_t hash = b.index.empty() ? 0 : __member_hash(key);
+  auto it = locate(b, key, hash);
+  if (it != b.data.end()) { return { it, false }; }
+  b.data.emplace_back(forward<K>(key), make());
+  it = prev(b.data.end());
+  index_member(b, it, hash);
   return { it, true };
 }
 
+static JsonRecordPtr
+__make_record(JsonRecord::Type type)
+{
+  switch (type) {
+  case JsonRecord::Type::OBJECT: return make_unique<JsonObjectImpl>();
+  case JsonRecord::Type::ARRAY:  return make_unique<JsonArrayImpl>();
+  case JsonRecord::Type::STRING: return make_unique<JsonStringImpl>();
+  default:                       return make_unique<JsonDataImpl>();
+  }
+}
+
+pair<JsonObject::iterator, bool>
+JsonObjectImpl::insert(value_type&& v)
+{
+  auto ret = emplace_member(pin(), std::move(v.first),
+                            [&v]() { return std::move(v.second); });
+  if (!ret.second) { ret.first = _body->data.end(); }
+  return ret;
+}
+
 pair<JsonObject::iterator, bool>
 JsonObjectImpl::insert(string_view key, JsonRecordPtr&& v)
 {
-  return insert(value_type(key, std::move(v)));
+  auto ret = emplace_member(pin(), key, [&v]() { return std::move(v); });
+  if (!ret.second) { ret.first = _body->data.end(); }
+  return ret;
 }
 
 pair<JsonObject::iterator, bool>
 JsonObjectImpl::insert(string_view key, const JsonRecordPtr& v)
 {
-  return insert(value_type(key, v->clone()));
+  auto ret = emplace_member(pin(), key, [&v]() { return v->clone(); });
+  if (!ret.second) { ret.first = _body->data.end(); }
+  return ret;
+}
+
+pair<JsonObject::iterator, bool>
+JsonObjectImpl::try_emplace(string&& key, JsonRecordPtr&& v)
+{
+  return emplace_member(pin(), std::move(key),
+                        [&v]() { return std::move(v); });
+}
+
+pair<JsonObject::iterator, bool>
+JsonObjectImpl::try_emplace(string&& key, JsonRecord::Type type)
+{
+  return emplace_member(pin(), std::move(key),
+                        [type]() { return __make_record(type); });
+}
+
+bool
+JsonObjectImpl::append(string_view key, JsonRecordPtr&& v)
+{
+  return emplace_member(own(), key, [&v]() { return std::move(v); }).second;
+}
+
+JsonObject::iterator
+JsonObjectImpl::find(string_view key)
+{
+  pin();
+  return locate(key);
+}
+
+JsonObject::const_iterator
+JsonObjectImpl::find(string_view key) const
+{
+  return locate(pinned_body(), key, 0);
+}
+
+JsonRecordPtr&
+JsonObjectImpl::at(string_view key)
+{
+  pin();
+  auto it = locate(key);
+  if (it == _body->data.end()) {
+    throw out_of_range("at(): key `" + string(key) + "' is not found.");
+  }
+  return it->second;
+}
+
+const JsonRecord*
+JsonObjectImpl::at(string_view key) const
+{
+  const body_t& b = pinned_body();
+  auto it = locate(b, key, 0);
+  if (it == b.data.end()) {
+    throw out_of_range("at(): key `" + string(key) + "' is not found.");
+  }
+  return it->second.get();
 }
 
 JsonObject::iterator
-JsonObjectImpl::find(const string& key)
+JsonObjectImpl::find(const JsonKey& key)
 {
-  if (_map.count(key) == 0) { return _data.end(); }
-  return _map.find(key)->second;
+  pin();
+  return locate(key.str(), key.hash());
 }
 
 JsonObject::const_iterator
-JsonObjectImpl::find(const string& key) const
+JsonObjectImpl::find(const JsonKey& key) const
 {
-  if (_map.count(key) == 0) { return _data.end(); }
-  return _map.find(key)->second;
+  return locate(pinned_body(), key.str(), key.hash());
 }
 
 JsonRecordPtr&
-JsonObjectImpl::at(const string& key)
+JsonObjectImpl::at(const JsonKey& key)
 {
-  return (*(_map.at(key))).second;
+  pin();
+  auto it = locate(key.str(), key.hash());
+  if (it == _body->data.end()) {
+    throw out_of_range("at(): key `" + key.str() + "' is not found.");
+  }
+  return it->second;
 }
 
 const JsonRecord*
-JsonObjectImpl::at(const string& key) const
+JsonObjectImpl::at(const JsonKey& key) const
 {
-  return (*(_map.at(key))).second.get();
+  const body_t& b = pinned_body();
+  auto it = locate(b, key.str(), key.hash());
+  if (it == b.data.end()) {
+    throw out_of_range("at(): key `" + key.str() + "' is not found.");
+  }
+  return it->second.get();
 }
 
 JsonObject::iterator
 JsonObjectImpl::erase(JsonObject::const_iterator it)
 {
-  _map.erase(it->first);
-  return _data.erase(it);
+  /* it is into the pinned body, which is not copied */
+  body_t& b = pin();
+  unindex_member(b, it);
+  return b.data.erase(it);
 }
 
 size_t
-JsonObjectImpl::erase(const string& key)
+JsonObjectImpl::erase(string_view key)
 {
-  auto mit = _map.find(key);
-  if (mit == _map.end()) { return 0; }
-  _data.erase(mit->second);
-  _map.erase(mit);
+  body_t& b = own();
+  auto it = locate(key);
+  if (it == b.data.end()) { return 0; }
+  unindex_member(b, it);
+  b.data.erase(it);
   return 1;
 }
 
-JsonRecordPtr&
-JsonObjectImpl::operator[](const string& key)
+void
+JsonObjectImpl::clear()
 {
-  if (_map.count(key) == 0) {
-    insert(value_type(key, unique_ptr<JsonRecord>()));
+  body_t* b = _body.get();
+  if (b && !b->shared()) {
+    b->data.clear();
+    b->index = vector<index_slot_t>();
+    b->retired.reset();
+  } else {
+    _body.reset(new body_t());
   }
-  return at(key);
 }
 
-////////////////////////////////////////////////////////////////////////////////
+size_t
+JsonObjectImpl::count(string_view key) const
+{
+  return locate(key) != body().data.end();
+}
+
+size_t
+JsonObjectImpl::count(const JsonKey& key) const
+{
+  return locate(key.str(), key.hash()) != body().data.end();
+}
 
-JsonArrayImpl::JsonArrayImpl(const JsonArrayImpl& src)
+JsonRecordPtr&
+JsonObjectImpl::operator[](string_view key)
 {
-  for (auto& entry : src._data) { _data.push_back(entry->clone()); }
+  return emplace_member(pin(), key, []() { return JsonRecordPtr(); })
+           .first->second;
 }
 
-JsonArrayImpl::JsonArrayImpl(JsonArrayImpl&& src) noexcept
-  : _data(std::move(src._data))
+////////////////////////////////////////////////////////////////////////////////
+
+JsonArrayImpl::JsonArrayImpl(const JsonArrayImpl& src) : _body(src.share())
+{}
+
+JsonArrayImpl::JsonArrayImpl(JsonArrayImpl&& src)
 {
-  src._data.clear();
+  src.body();
+  _body = std::move(src._body);
 }
 
 JsonArray&
 JsonArrayImpl::operator=(const JsonArray& src)
 {
   if (this == &src) { return *this; }
-  _data.clear();
   const JsonArrayImpl& src_impl = static_cast<const JsonArrayImpl&>(src);
-  for (auto& entry : src_impl._data) { _data.push_back(entry->clone()); }
+  _body = src_impl.share();
   return *this;
 }
 
 JsonArray&
 JsonArrayImpl::operator=(JsonArray&& src)
 {
-  _data.clear();
   JsonArrayImpl&& src_impl = static_cast<JsonArrayImpl&&>(src);
-  _data = std::move(src_impl._data);
-  src_impl._data.clear();
+  src_impl.body();
+  __body_ptr<body_t> body = std::move(src_impl._body);
+  _body = std::move(body);
   return *this;
 }
 
 void
 JsonArrayImpl::unlink_child_records(deque<JsonRecord*>& ptrs)
 {
-  for (auto& item : _data) {
+  body_t* b = _body.release();
+  if (!b || !b->unref()) { return; }
+  for (auto& item : b->data) {
     auto ptr = item.release();
     if (ptr) { ptrs.push_back(ptr); }
   }
-  _data.clear();
+  __delete_body(b);
 }
 
 JsonArrayImpl::~JsonArrayImpl() noexcept
@@ -610,23 +1862,102 @@ JsonArrayImpl::~JsonArrayImpl() noexcept
 JsonRecordPtr
 JsonArrayImpl::clone() const
 {
-  JsonArrayPtr ret = make_json_array();
-  for (const auto& item : _data) {
-    ret->push_back(item->clone());
+  return make_unique<JsonArrayImpl>(*this);
+}
+
+const JsonArrayImpl::body_t&
+JsonArrayImpl::body() const
+{
+  const body_t* b = _body.get();
+  if (!b && !(b = load_body())) { return __empty_body<body_t>(); }
+  return *b;
+}
+
+const JsonArrayImpl::body_t&
+JsonArrayImpl::unshare() const
+{
+  lock_guard<mutex> lock(__unshare_mutex(this));
+  const body_t* b = _body.get();
+  if (b->try_pin()) { return *b; }
+  __body_ptr<body_t> copy = copy_body(*b);
+  copy->pin();
+  _body.replace(std::move(copy));
+  return *_body;
+}
+
+JsonArrayImpl::body_t&
+JsonArrayImpl::own()
+{
+  body_t* b = _body.get();
+  if (!b) { b = const_cast<body_t*>(load_body()); }
+  if (!b) { _body.reset(b = new body_t()); }
+  else if (b->shared()) { _body = copy_body(*b); b = _body.get(); }
+  else if (b->retired) { b->retired.reset(); }
+  return *b;
+}
+
+__body_ptr<JsonArrayImpl::body_t>
+JsonArrayImpl::share() const
+{
+  const body_t& b = body();
+  if (!in_arena() && b.try_share()) {
+    return const_cast<body_t*>(&b);
+  }
+  return copy_body(b);
+}
+
+__body_ptr<JsonArrayImpl::body_t>
+JsonArrayImpl::copy_body(const body_t& src)
+{
+  __body_ptr<body_t> body(new body_t());
+  body->data.reserve(src.data.size());
+  for (const auto& item : src.data) {
+    body->data.push_back(item ? item->clone() : nullptr);
+  }
+  return body;
+}
+
+void
+JsonArrayImpl::splice(vector<JsonArrayImpl*>& others)
+{
+  body_t& b = own();
+  size_t size = b.data.size();
+  for (JsonArrayImpl* other : others) { size += other->size(); }
+  b.data.reserve(size);
+  for (JsonArrayImpl* other : others) {
+    body_t& other_body = other->own();
+    b.data.insert(b.data.end(), make_move_iterator(other_body.data.begin()),
+                  make_move_iterator(other_body.data.end()));
+    other_body.data.clear();
   }
-  return ret;
 }
 
 void
 JsonArrayImpl::push_back(JsonRecordPtr&& v)
 {
-  _data.push_back(std::move(v));
+  pin().data.push_back(std::move(v));
 }
 
 void
 JsonArrayImpl::push_back(const JsonRecordPtr& v)
 {
-  _data.push_back(v->clone());
+  own().data.push_back(v->clone());
+}
+
+JsonRecordPtr&
+JsonArrayImpl::emplace_back(JsonRecord::Type type)
+{
+  body_t& b = pin();
+  b.data.push_back(__make_record(type));
+  return b.data.back();
+}
+
+void
+JsonArrayImpl::clear()
+{
+  body_t* b = _body.get();
+  if (b && !b->shared()) { b->data.clear(); b->retired.reset(); }
+  else { _body.reset(new body_t()); }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -720,6 +2051,8 @@ JsonDataImpl::to_string() const
     return std::to_string(_content.d);
   case NativeType::INT:
     return std::to_string(static_cast<int64_t>(_content.l));
+  case NativeType::LAZY:
+    return lazy_value().to_string();
   default:
     throw runtime_error("JsonData::to_string(): unknown native type.");
   }
@@ -738,6 +2071,8 @@ JsonDataImpl::as_bool() const
     return _content.d != 0.;
   case NativeType::INT:
     return _content.l != 0;
+  case NativeType::LAZY:
+    return lazy_value().as_bool();
   default:
     throw runtime_error("JsonData::as_bool(): unknown native type.");
   }
@@ -756,6 +2091,8 @@ JsonDataImpl::as_double() const
     return _content.d;
   case NativeType::INT:
     return static_cast<double>(static_cast<int64_t>(_content.l));
+  case NativeType::LAZY:
+    return lazy_value().as_double();
   default:
     throw runtime_error("JsonData::as_double(): unknown native type.");
   }
@@ -774,6 +2111,8 @@ JsonDataImpl::as_int() const
     return static_cast<long long>(_content.d);
   case NativeType::INT:
     return static_cast<long long>(_content.l);
+  case NativeType::LAZY:
+    return lazy_value().as_int();
   default:
     throw runtime_error("JsonData::as_int(): unknown native type.");
   }
@@ -792,6 +2131,8 @@ JsonDataImpl::as_unsigned() const
     return static_cast<uint64_t>(_content.d);
   case NativeType::INT:
     return static_cast<uint64_t>(_content.l);
+  case NativeType::LAZY:
+    return lazy_value().as_unsigned();
   default:
     throw runtime_error("JsonData::as_unsigned(): unknown native type.");
   }
@@ -814,7 +2155,8 @@ JsonString&
 JsonStringImpl::operator=(const JsonString& src)
 {
   if (this == &src) { return *this; }
-  _content = static_cast<const JsonStringImpl&>(src)._content;
+  const JsonStringImpl& src_impl = static_cast<const JsonStringImpl&>(src);
+  _content = src_impl._content;
   return *this;
 }
 
@@ -822,7 +2164,8 @@ JsonString&
 JsonStringImpl::operator=(JsonString&& src) noexcept
 {
   if (this == &src) { return *this; }
-  _content = std::move(static_cast<JsonStringImpl&&>(src)._content);
+  JsonStringImpl&& src_impl = static_cast<JsonStringImpl&&>(src);
+  _content = std::move(src_impl._content);
   return *this;
 }
 
@@ -868,6 +2211,53 @@ JsonStringImpl::as_unsigned() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+shared_ptr<const string>
+JsonStringPoolImpl::intern(string_view value)
+{
+  static const size_t inline_capacity = string().capacity();
+  if (value.size() <= inline_capacity || value.size() > _max_length) {
+    return nullptr;
+  }
+  lock_guard<mutex> lock(_mtx);
+  auto it = _strings.find(value);
+  if (it != _strings.end()) { return it->second; }
+  shared_ptr<const string> ret = make_shared<const string>(value);
+  _strings.emplace(*ret, ret);
+  return ret;
+}
+
+shared_ptr<const string>
+__document_string_pool::intern(string_view value)
+{
+  static const size_t inline_capacity = string().capacity();
+  if (value.size() <= inline_capacity || value.size() > _max_length) {
+    return nullptr;
+  }
+  auto it = _storage->index.find(value);
+  if (it == _storage->index.end()) {
+    const string& pooled = _storage->strings.emplace_back(value);
+    it = _storage->index.emplace(pooled, &pooled).first;
+  }
+  /* shares the ownership of the whole storage */
+  return shared_ptr<const string>(_storage, it->second);
+}
+
+size_t
+JsonStringPoolImpl::size() const
+{
+  lock_guard<mutex> lock(_mtx);
+  return _strings.size();
+}
+
+void
+JsonStringPoolImpl::clear()
+{
+  lock_guard<mutex> lock(_mtx);
+  _strings.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 JsonObjectPtr
 make_json_object()
 {
@@ -944,6 +2334,24 @@ make_json_string(string_view value)
   return make_unique<JsonStringImpl>(value);
 }
 
+JsonStringPtr
+make_json_string(string&& value)
+{
+  return make_unique<JsonStringImpl>(std::move(value));
+}
+
+JsonStringPtr
+make_json_string(const char* value)
+{
+  return make_unique<JsonStringImpl>(string_view(value));
+}
+
+JsonStringPoolPtr
+make_json_string_pool(size_t max_length)
+{
+  return make_unique<JsonStringPoolImpl>(max_length);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define DISABLE_CONVERSION(dest, Dest)                                         \
@@ -964,323 +2372,3859 @@ DISABLE_CONVERSION(string, String);
 ////////////////////////////////////////////////////////////////////////////////
 // deserialization functions
 
-JsonRecordPtr
-make_json_scalar(istream& istrm, const d_config_t& cfg)
+static const double __exact_powers_of_ten[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* converts the decimal number in [begin, end), which may carry a leading
+ * '-', but not a '+' */
+static double
+__parse_double(const char* begin, const char* end)
 {
-  // Skip leading whitespace characters in the input stream
-  __skip_no_parse(istrm);
-  if (istrm.eof()) {
-    return JsonRecordPtr();  /* return nullptr if nothing matched */
-  }
-  if (istrm.peek() == '"' || istrm.peek() == '\'') {
-    unique_ptr<JsonStringImpl> ret = make_unique<JsonStringImpl>();
-    ret->_content = __retrieve_quoted_string(istrm);
-    return ret;
-  } else {
-    unique_ptr<JsonDataImpl> ret = make_unique<JsonDataImpl>();
-    // read till a separator
-    string token;
-    while (istrm && !istrm.eof()) {
-      char c = istrm.peek();
-      if (std::isspace(c) || c == ',' || c == ']' || c == '}') { break; }
-      token += static_cast<char>(istrm.get());
-    }
-    if (token.empty()) {
-      return JsonDataPtr();  /* return nullptr if nothing matched */
-    }
-    if (token == "null") {
-      ret->_native_type = JsonDataImpl::NativeType::NONE;
-      ret->_content.l = 0;
-    } else if (token == "true") {
-      ret->_native_type = JsonDataImpl::NativeType::BOOL;
-      ret->_content.l = 1;
-    } else if (token == "false") {
-      ret->_native_type = JsonDataImpl::NativeType::BOOL;
-      ret->_content.l = 0;
-    } else {
-      if (token[0] == '+') {
-        assert_msg(token.size() > 1, "unexpected token `+' without a number.");
-        assert_msg(token[1] != '-', "unexpected token `+-'.");
-        token = token.substr(1);
-      }
-      if (token.find(".") != string::npos) {
-        ret->_native_type = JsonDataImpl::NativeType::FLOAT;
-        size_t after_pos = 0;
-        ret->_content.d = stod(token, &after_pos);
-        assert_msg(after_pos == token.size(), "unexpected trailing characters "
-                   "after floating point number.");
-      } else {
-        ret->_native_type = JsonDataImpl::NativeType::INT;
-        size_t after_pos = 0;
-        ret->_content.l = stoll(token, &after_pos, 0);
-        assert_msg(after_pos == token.size(), "unexpected trailing characters "
-                   "after integer number.");
-      }
-    }
-    return ret;
-  }
-  return JsonRecordPtr();
+  double value = 0.;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  auto result = from_chars(begin, end, value);
+  assert_msg(result.ec == errc() && result.ptr == end,
+             "floating point number `" << string_view(begin, end - begin)
+             << "' is out of range.");
+#else
+  string token(begin, end);
+  char* after = nullptr;
+  errno = 0;
+  value = strtod(token.c_str(), &after);
+  assert_msg(errno != ERANGE && after == token.c_str() + token.size(),
+             "floating point number `" << token << "' is out of range.");
+#endif
+  return value;
 }
 
-enum class JsonDeserializeState : uint8_t {
-  OBJECT_OPEN,
-  OBJECT_KEY,
-  OBJECT_COLON,
-  OBJECT_VALUE,
-  OBJECT_COMMA,
-  OBJECT_CLOSE,
-  ARRAY_OPEN,
-  ARRAY_ENTRY,
-  ARRAY_COMMA,
-  ARRAY_CLOSE
+/* a number as converted by the tokenizer, before it is handed over */
+struct des_number_t {
+  bool is_int;
+  union { int64_t l; double d; };
+  void set(int64_t v) { is_int = true; l = v; }
+  void set(double v) { is_int = false; d = v; }
 };
 
-struct des_job_state_t {
-  JsonDeserializeState state;
-  JsonRecord* record;
-  string active_key;
-};
+template <typename H>
+static inline void
+__emit_number(H& handler, const des_number_t& num)
+{
+  if (num.is_int) { handler.on_integer(num.l); }
+  else { handler.on_number(num.d); }
+}
 
-void
-handle_array_open(istream& istrm, const d_config_t& cfg,
-                  std::stack<des_job_state_t>& job_stack,
-                  JsonRecordPtr& root_record)
-{
-  assert_msg(istrm.peek() == '[', "expecting opening square bracket.");
-  istrm.get();  /* consume the opening square bracket */
-  unique_ptr<JsonArrayImpl> ret = make_unique<JsonArrayImpl>();
-  des_job_state_t* active_job = nullptr;
-  if (!job_stack.empty()) active_job = &(job_stack.top());
-  job_stack.push({ JsonDeserializeState::ARRAY_ENTRY, ret.get(), string() });
-  if (active_job) {
-    switch (active_job->state) {
-    case JsonDeserializeState::ARRAY_ENTRY:
-      static_cast<JsonArray*>(active_job->record)
-        ->push_back(std::move(ret));
-      active_job->state = JsonDeserializeState::ARRAY_COMMA;
-      break;
-    case JsonDeserializeState::OBJECT_VALUE:
-      static_cast<JsonObject*>(active_job->record)
-        ->insert(active_job->active_key, std::move(ret));
-      active_job->state = JsonDeserializeState::OBJECT_COMMA;
-      break;
-    default:
-      assert_msg(0, "unexpected state.");
-    }
-  } else {
-    root_record = std::move(ret);
+/* Scans a number starting at begin and converts it in the same pass, with
+ * no intermediate string. Decimal numbers of up to 19 significant digits and
+ * small exponents are converted exactly with one multiplication or division
+ * (Clinger's fast path); other floating point numbers go through
+ * from_chars(). json5 adds a leading '+', hexadecimal integers and a bare
+ * leading or trailing decimal point. cur is left after the last character
+ * scanned; false is returned if the characters don't form a number.
+ */
+static bool
+__parse_json_number(const char* begin, const char*& cur, const char* end,
+                    bool strict, des_number_t& ret)
+{
+  const char* p = begin;
+  bool negative = false;
+  if (p != end && *p == '-') {
+    negative = true; ++ p;
+  } else if (!strict && p != end && *p == '+') {
+    ++ p;
+    assert_msg(p != end, "unexpected token `+' without a number.");
+    assert_msg(*p != '-', "unexpected token `+-'.");
+  }
+  const char* digits = p;
+  if (!strict && end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    uint64_t value = 0;
+    auto result = from_chars(p + 2, end, value, 16);
+    cur = result.ptr;
+    if (result.ptr == p + 2) { return false; }
+    /* the magnitude of INT64_MIN is one more than INT64_MAX */
+    uint64_t limit = uint64_t(numeric_limits<int64_t>::max()) + negative;
+    assert_msg(result.ec == errc() && value <= limit, "hexadecimal number `"
+               << string_view(begin, cur - begin) << "' is out of range.");
+    ret.set(static_cast<int64_t>(negative ? 0 - value : value));
+    return true;
+  }
+  uint64_t mantissa = 0;
+  int significant = 0, exp10 = 0;
+  bool truncated = false, is_float = false;
+  auto take_digit = [&](unsigned d) {
+    if (mantissa == 0 && d == 0) { return; }
+    if (significant < 19) { mantissa = mantissa * 10 + d; ++ significant; }
+    else { truncated = true; }
+  };
+  size_t n_int = 0, n_frac = 0;
+  for (; p != end && static_cast<unsigned>(*p - '0') < 10; ++ p, ++ n_int)
+  { take_digit(*p - '0'); if (truncated) { ++ exp10; } }
+  if (strict && (n_int == 0 || (n_int > 1 && *digits == '0'))) {
+    cur = p; return false;
+  }
+  if (p != end && *p == '.') {
+    is_float = true;
+    for (++ p; p != end && static_cast<unsigned>(*p - '0') < 10;
+         ++ p, ++ n_frac)
+    { take_digit(*p - '0'); if (!truncated) { -- exp10; } }
+    if (strict && n_frac == 0) { cur = p; return false; }
+  }
+  if (n_int + n_frac == 0) { cur = p; return false; }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    is_float = true;
+    ++ p;
+    bool exp_negative = false;
+    if (p != end && (*p == '+' || *p == '-')) { exp_negative = *p++ == '-'; }
+    int exponent = 0;
+    const char* exp_digits = p;
+    for (; p != end && static_cast<unsigned>(*p - '0') < 10; ++ p) {
+      if (exponent < 100000) { exponent = exponent * 10 + (*p - '0'); }
+    }
+    if (p == exp_digits) { cur = p; return false; }
+    exp10 += exp_negative ? -exponent : exponent;
+  }
+  cur = p;
+  if (!is_float) {
+    if (significant <= 18) {
+      int64_t value = static_cast<int64_t>(mantissa);
+      ret.set(negative ? -value : value);
+      return true;
+    }
+    int64_t value = 0;
+    auto result = from_chars(negative ? digits - 1 : digits, p, value);
+    assert_msg(result.ec == errc(), "integer `"
+               << string_view(begin, cur - begin) << "' is out of range.");
+    ret.set(value);
+    return true;
+  }
+  if (!truncated && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+    double value = static_cast<double>(mantissa);
+    value = exp10 < 0 ? value / __exact_powers_of_ten[-exp10]
+                      : value * __exact_powers_of_ten[exp10];
+    ret.set(negative ? -value : value);
+    return true;
+  }
+  ret.set(__parse_double(negative ? digits - 1 : digits, p));
+  return true;
+}
+
+/* hands an unquoted token over as a null, boolean or number */
+template <typename H>
+static void
+__emit_json_token(H& handler, const char* begin, const char* end,
+                  bool strict = false)
+{
+  size_t len = end - begin;
+  if (len == 4 && memcmp(begin, "null", 4) == 0) {
+    handler.on_null(); return;
+  } else if (len == 4 && memcmp(begin, "true", 4) == 0) {
+    handler.on_bool(true); return;
+  } else if (len == 5 && memcmp(begin, "false", 5) == 0) {
+    handler.on_bool(false); return;
+  }
+  const char* after = begin;
+  des_number_t num;
+  assert_msg(__parse_json_number(begin, after, end, strict, num),
+             "unexpected token `" << string_view(begin, len) << "'.");
+  assert_msg(after == end, "unexpected trailing characters after number `"
+             << string_view(begin, after - begin) << "'.");
+  __emit_number(handler, num);
+}
+
+/* Reads a string or an unquoted token and hands it over; the input is
+ * positioned on the first character.
+ */
+template <typename H>
+static void
+__emit_json_scalar(istream& istrm, string& scratch, H& handler)
+{
+  int c = istrm.peek();
+  if (c == '"' || c == '\'') {
+    handler.on_string(__retrieve_quoted_string(istrm, scratch));
+    return;
+  }
+  scratch.clear();
+  while ((c = istrm.peek()) != EOF && !__is_scalar_end(c)) {
+    scratch += static_cast<char>(istrm.get());
+  }
+  __emit_json_token(handler, scratch.data(), scratch.data() + scratch.size());
+}
+
+template <typename H>
+static void
+__emit_json_scalar(des_buffer_t& buf, string& scratch, H& handler)
+{
+  if (*buf.cur == '"' || *buf.cur == '\'') {
+    handler.on_string(__retrieve_quoted_string(buf, scratch));
+    return;
+  }
+  const char* begin = buf.cur;
+  while (buf.cur != buf.end && !__is_scalar_end(*buf.cur)) { ++ buf.cur; }
+  if (buf.cur == buf.end && buf.partial) { throw __incomplete_input(); }
+  __emit_json_token(handler, begin, buf.cur);
+}
+
+enum class JsonDeserializeState : uint8_t {
+  ROOT_VALUE,
+  ROOT_END,
+  OBJECT_KEY,
+  OBJECT_COLON,
+  OBJECT_VALUE,
+  OBJECT_COMMA,
+  ARRAY_ENTRY,
+  ARRAY_COMMA
+};
+
+/* Builds the records of a document from the parser events. It is final, so
+ * that the tokenizers instantiated for it call it without virtual dispatch.
+ */
+class __dom_builder final : public JsonHandler {
+public:
+  /* String values are interned in cfg.string_pool, or with
+   * cfg.intern_strings in a pool of the builder's own. The records are
+   * allocated from arena if set.
+   */
+  explicit __dom_builder(const d_config_t& cfg, __arena* arena = nullptr)
+    : _pool(static_pointer_cast<JsonStringPoolImpl>(cfg.string_pool)),
+      _arena(arena)
+  {
+    if (!_pool && cfg.intern_strings) {
+      _own_pool = make_unique<__document_string_pool>(64);
+    }
+  };
+
+  void on_object_begin()
+    { if (!dropped(1)) { open(create<JsonObjectImpl>(), true); } }
+  void on_object_end()   { if (!dropped(-1)) { _frames.pop_back(); } }
+  void on_array_begin()
+    { if (!dropped(1)) { open(create<JsonArrayImpl>(), false); } }
+  void on_array_end()    { if (!dropped(-1)) { _frames.pop_back(); } }
+  void on_key(string_view key)
+    { if (!dropped(0)) { _key.assign(key.data(), key.size()); } }
+  void on_string(string_view value)
+  {
+    if (dropped(0)) { return; }
+    shared_ptr<const string> pooled = _pool ? _pool->intern(value)
+                                      : _own_pool ? _own_pool->intern(value)
+                                      : nullptr;
+    if (pooled) { attach(create<JsonPooledStringImpl>(std::move(pooled))); }
+    else { attach(create<JsonStringImpl>(value)); }
+  }
+  void on_number(double value)
+    { if (!dropped(0)) { attach(create<JsonDataImpl>(value)); } }
+  void on_integer(long long value)
+  {
+    if (dropped(0)) { return; }
+    attach(create<JsonDataImpl>(static_cast<int64_t>(value)));
+  }
+  void on_bool(bool value)
+    { if (!dropped(0)) { attach(create<JsonDataImpl>(value)); } }
+  void on_null() { if (!dropped(0)) { attach(create<JsonDataImpl>()); } }
+
+  JsonRecordPtr release() { return std::move(_root); }
+
+private:
+  struct frame_t {
+    JsonRecord* record;
+    bool        is_object;
+  };
+
+  /* The first of duplicate keys wins: an array or object under a later one
+   * is not attached, and the events of its content are dropped. depth is 1
+   * for the beginning of an array or object, -1 for its end, 0 otherwise.
+   */
+  bool dropped(int depth)
+  {
+    if (!_drop_depth) { return false; }
+    _drop_depth += depth;
+    return true;
+  }
+
+  template <typename T, typename... Args>
+  JsonRecordPtr create(Args&&... args)
+  {
+    if (_arena) {
+      return JsonRecordPtr(
+               __new_arena_record<T>(*_arena, forward<Args>(args)...));
+    }
+    return make_unique<T>(forward<Args>(args)...);
+  }
+  /* false if rec is dropped, under a duplicate key */
+  bool attach(JsonRecordPtr&& rec)
+  {
+    if (_frames.empty()) {
+      _root = std::move(rec);
+    } else if (_frames.back().is_object) {
+      return static_cast<JsonObjectImpl*>(_frames.back().record)
+               ->append(_key, std::move(rec));
+    } else {
+      static_cast<JsonArrayImpl*>(_frames.back().record)
+        ->append(std::move(rec));
+    }
+    return true;
+  }
+  void open(JsonRecordPtr&& rec, bool is_object)
+  {
+    JsonRecord* container = rec.get();
+    if (attach(std::move(rec))) {
+      _frames.push_back({ container, is_object });
+    } else {
+      _drop_depth = 1;
+    }
+  }
+
+  vector<frame_t>                    _frames;
+  long                               _drop_depth = 0;
+  string                             _key;
+  JsonRecordPtr                      _root;
+  shared_ptr<JsonStringPoolImpl>     _pool;
+  unique_ptr<__document_string_pool> _own_pool;
+  __arena*                           _arena;
+};
+
+/* Parsing state between two tokens: the job stack holds the state of the
+ * innermost array or object at its top, and its bottom entry stands for the
+ * document itself. Decoded strings and keys are staged in scratch.
+ */
+struct des_context_t {
+  vector<JsonDeserializeState> job_stack;
+  string scratch;
+  des_context_t() { job_stack.push_back(JsonDeserializeState::ROOT_VALUE); }
+};
+
+/* moves the enclosing array or object past a completed value */
+static inline void
+__complete_value(JsonDeserializeState& state)
+{
+  if (state == JsonDeserializeState::ARRAY_ENTRY) {
+    state = JsonDeserializeState::ARRAY_COMMA;
+  } else if (state == JsonDeserializeState::OBJECT_VALUE) {
+    state = JsonDeserializeState::OBJECT_COMMA;
+  } else if (state == JsonDeserializeState::ROOT_VALUE) {
+    state = JsonDeserializeState::ROOT_END;
+  }
+}
+
+/* The tokenizer is shared by the istream and the contiguous buffer inputs;
+ * `In' is either istream or des_buffer_t, and `H' is the JsonHandler the
+ * events go to. Each call consumes one token, which costs one lookup in the
+ * character class table and a switch over the state at the top of the job
+ * stack. Events are only sent and the context only updated once the token
+ * is complete, so a partial buffer can be rewound to the start of the token
+ * on __incomplete_input. Returns false at the end of the input.
+ */
+template <typename In, typename H>
+static bool
+__parse_json5_token(In& istrm, des_context_t& ctx, H& handler)
+{
+  __skip_no_parse(istrm);
+  int c = istrm.peek();
+  if (c == EOF) { return false; }
+  uint8_t cc = __json5_char_class[c];
+  vector<JsonDeserializeState>& job_stack = ctx.job_stack;
+  JsonDeserializeState& state = job_stack.back();
+  switch (state) {
+  case JsonDeserializeState::OBJECT_KEY:
+    if (cc == __CC_OBJECT_CLOSE) {
+      istrm.get(); job_stack.pop_back();
+      handler.on_object_end();
+      break;
+    }
+    assert_msg(cc == __CC_QUOTE || cc == __CC_OTHER,
+               "unexpected character `" << static_cast<char>(c)
+               << "' in place of json object key.");
+    {
+      string_view key = cc == __CC_QUOTE
+                          ? __retrieve_quoted_string(istrm, ctx.scratch)
+                          : __retrieve_unquoted_key(istrm, ctx.scratch);
+      assert_msg(key.length(),
+                 "unexpected non-json characters in json object key.");
+      state = JsonDeserializeState::OBJECT_COLON;
+      handler.on_key(key);
+    }
+    break;
+  case JsonDeserializeState::OBJECT_COLON:
+    assert_msg(cc == __CC_COLON, "unexpected character `"
+               << static_cast<char>(c) << "' in place of colon.");
+    istrm.get();
+    state = JsonDeserializeState::OBJECT_VALUE;
+    break;
+  case JsonDeserializeState::OBJECT_COMMA:
+    assert_msg(cc == __CC_COMMA || cc == __CC_OBJECT_CLOSE,
+               "unexpected character `" << static_cast<char>(c)
+               << "' after value in json object.");
+    istrm.get();
+    if (cc == __CC_COMMA) { state = JsonDeserializeState::OBJECT_KEY; }
+    else { job_stack.pop_back(); handler.on_object_end(); }
+    break;
+  case JsonDeserializeState::ARRAY_COMMA:
+    assert_msg(cc == __CC_COMMA || cc == __CC_ARRAY_CLOSE,
+               "unexpected character `" << static_cast<char>(c)
+               << "' after entry in json array.");
+    istrm.get();
+    if (cc == __CC_COMMA) { state = JsonDeserializeState::ARRAY_ENTRY; }
+    else { job_stack.pop_back(); handler.on_array_end(); }
+    break;
+  case JsonDeserializeState::ROOT_END:
+    assert_msg(0, "unexpected character `" << static_cast<char>(c)
+               << "' after the json value.");
+    break;
+  case JsonDeserializeState::ARRAY_ENTRY:
+    if (cc == __CC_ARRAY_CLOSE) {
+      istrm.get(); job_stack.pop_back();
+      handler.on_array_end();
+      break;
+    }
+    /* fall through */
+  default:
+    switch (cc) {
+    case __CC_OBJECT_OPEN:
+      istrm.get();
+      __complete_value(state);
+      job_stack.push_back(JsonDeserializeState::OBJECT_KEY);
+      handler.on_object_begin();
+      break;
+    case __CC_ARRAY_OPEN:
+      istrm.get();
+      __complete_value(state);
+      job_stack.push_back(JsonDeserializeState::ARRAY_ENTRY);
+      handler.on_array_begin();
+      break;
+    case __CC_QUOTE:
+    case __CC_OTHER:
+      __emit_json_scalar(istrm, ctx.scratch, handler);
+      __complete_value(state);
+      break;
+    default:
+      assert_msg(0, "unexpected character `" << static_cast<char>(c)
+                 << "' in place of json value.");
+    }
+  }
+  return true;
+}
+
+/* called once the input is exhausted */
+static void
+__finish_json5(des_context_t& ctx)
+{
+  JsonDeserializeState state = ctx.job_stack.back();
+  assert_msg(ctx.job_stack.size() == 1,
+             "unexpected end of input in json "
+             << (state == JsonDeserializeState::ARRAY_ENTRY ||
+                 state == JsonDeserializeState::ARRAY_COMMA
+                   ? "array." : "object."));
+}
+
+template <typename In, typename H>
+static void
+__parse_json5(In& istrm, H& handler)
+{
+  des_context_t ctx;
+  while (__parse_json5_token(istrm, ctx, handler)) {}
+  __finish_json5(ctx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// strict json deserialization
+//
+// Inputs known to be RFC 8259 json are parsed in two stages. The first stage
+// classifies the input 64 bytes at a time with vector compares, and collects
+// the offsets of the structural characters outside of strings, of the quotes
+// delimiting strings, and of the first character of every number or literal.
+// The second stage builds the records by walking only those offsets.
+
+enum : uint8_t {
+  __SC_QUOTE      = 1,
+  __SC_BACKSLASH  = 2,
+  __SC_STRUCTURAL = 4,
+  __SC_WHITESPACE = 8,
+  __SC_CONTROL    = 16,
+};
+
+static const array<uint8_t, 256> __strict_char_class = []() {
+  array<uint8_t, 256> ret = { 0 };
+  for (int c=0; c<0x20; ++c) { ret[c] = __SC_CONTROL; }
+  ret['"']  = __SC_QUOTE;
+  ret['\\'] = __SC_BACKSLASH;
+  for (char c : { '{', '}', '[', ']', ':', ',' }) { ret[c] = __SC_STRUCTURAL; }
+  for (char c : { ' ', '\t', '\n', '\r' }) { ret[c] |= __SC_WHITESPACE; }
+  return ret;
+}();
+
+struct __block_masks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t structural;
+  uint64_t whitespace;
+  uint64_t control;
+};
+
+typedef void (*__classify_fn)(const unsigned char*, __block_masks&);
+
+static void
+__classify_block_scalar(const unsigned char* block, __block_masks& m)
+{
+  m = __block_masks();
+  for (int i=0; i<64; ++i) {
+    uint64_t sc = __strict_char_class[block[i]];
+    m.quote      |= (sc & 1) << i;
+    m.backslash  |= ((sc >> 1) & 1) << i;
+    m.structural |= ((sc >> 2) & 1) << i;
+    m.whitespace |= ((sc >> 3) & 1) << i;
+    m.control    |= ((sc >> 4) & 1) << i;
+  }
+}
+
+#ifdef J5SERDES_X86_SIMD
+__attribute__((target("sse2")))
+static void
+__classify_block_sse2(const unsigned char* block, __block_masks& m)
+{
+  m = __block_masks();
+  for (int i=0; i<4; ++i) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block)
+                                + i);
+    /* '[' and ']' map onto '{' and '}' once the 0x20 bit is set */
+    __m128i lx = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    __m128i st = _mm_or_si128(
+                   _mm_or_si128(_mm_cmpeq_epi8(lx, _mm_set1_epi8('{')),
+                                _mm_cmpeq_epi8(lx, _mm_set1_epi8('}'))),
+                   _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(':')),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8(','))));
+    __m128i ws = _mm_or_si128(
+                   _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                   _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+    __m128i ct = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(0x1f)), x);
+    __m128i qt = _mm_cmpeq_epi8(x, _mm_set1_epi8('"'));
+    __m128i bs = _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'));
+    int shift = 16 * i;
+    m.quote      |= uint64_t(uint16_t(_mm_movemask_epi8(qt))) << shift;
+    m.backslash  |= uint64_t(uint16_t(_mm_movemask_epi8(bs))) << shift;
+    m.structural |= uint64_t(uint16_t(_mm_movemask_epi8(st))) << shift;
+    m.whitespace |= uint64_t(uint16_t(_mm_movemask_epi8(ws))) << shift;
+    m.control    |= uint64_t(uint16_t(_mm_movemask_epi8(ct))) << shift;
+  }
+}
+
+__attribute__((target("avx2")))
+static void
+__classify_block_avx2(const unsigned char* block, __block_masks& m)
+{
+  m = __block_masks();
+  for (int i=0; i<2; ++i) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)
+                                   + i);
+    __m256i lx = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+#define CMPEQ(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+#define OR(a, b)    _mm256_or_si256(a, b)
+    __m256i st = OR(OR(CMPEQ(lx, '{'), CMPEQ(lx, '}')),
+                    OR(CMPEQ(x, ':'), CMPEQ(x, ',')));
+    __m256i ws = OR(OR(CMPEQ(x, ' '), CMPEQ(x, '\t')),
+                    OR(CMPEQ(x, '\n'), CMPEQ(x, '\r')));
+#undef OR
+#undef CMPEQ
+    __m256i ct = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(0x1f)),
+                                   x);
+    __m256i qt = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('"'));
+    __m256i bs = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'));
+    int shift = 32 * i;
+    m.quote      |= uint64_t(uint32_t(_mm256_movemask_epi8(qt))) << shift;
+    m.backslash  |= uint64_t(uint32_t(_mm256_movemask_epi8(bs))) << shift;
+    m.structural |= uint64_t(uint32_t(_mm256_movemask_epi8(st))) << shift;
+    m.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+    m.control    |= uint64_t(uint32_t(_mm256_movemask_epi8(ct))) << shift;
+  }
+}
+#endif
+
+/* picks the widest classifier supported by the running cpu */
+static __classify_fn
+__select_classify_block()
+{
+#ifdef J5SERDES_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))   { return __classify_block_avx2; }
+  if (__builtin_cpu_supports("sse2"))   { return __classify_block_sse2; }
+#endif
+  return __classify_block_scalar;
+}
+
+static inline uint64_t
+__prefix_xor(uint64_t x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/* A backslash escapes the next byte, unless it is escaped itself. carry
+ * tells whether the first byte of the block is escaped, and is updated for
+ * the next block.
+ */
+static inline uint64_t
+__escaped_bytes(uint64_t backslash, uint64_t& carry)
+{
+  uint64_t escaped = carry;
+  uint64_t bs = backslash & ~escaped;
+  carry = 0;
+  while (bs) {
+    int i = __builtin_ctzll(bs);
+    if (i == 63) { carry = 1; break; }
+    escaped |= 2ull << i;
+    bs &= ~(3ull << i);
+  }
+  return escaped;
+}
+
+/* Produces the structural offsets of a buffer one window at a time, so the
+ * offsets in flight stay cache resident regardless of the document size.
+ */
+class __structural_indexer {
+public:
+  explicit __structural_indexer(string_view sv);
+
+  /* restarts on another input, keeping the offset buffer */
+  void reset(string_view sv);
+
+  /* returns false when the offsets are exhausted */
+  bool next(size_t& offset)
+  {
+    while (_pos == _count) {
+      if (_window_end == _size) { return false; }
+      index_window();
+    }
+    offset = _window_begin + _offsets[_pos++];
+    return true;
+  };
+
+private:
+  void index_window();
+
+  static constexpr size_t WINDOW_SIZE = 1 << 16;
+
+  const unsigned char* _data;
+  size_t               _size;
+  size_t               _window_begin;
+  size_t               _window_end;
+  vector<uint32_t>     _offsets;
+  size_t               _count;
+  size_t               _pos;
+  uint64_t             _in_string;  /* all ones while inside a string */
+  uint64_t             _escaped;    /* first byte of next block is escaped */
+  uint64_t             _separated;  /* last byte of prev block separates */
+  __classify_fn        _classify;
+};
+
+__structural_indexer::__structural_indexer(string_view sv)
+{
+  static const __classify_fn classify = __select_classify_block();
+  _classify = classify;
+  reset(sv);
+}
+
+void
+__structural_indexer::reset(string_view sv)
+{
+  _data = reinterpret_cast<const unsigned char*>(sv.data());
+  _size = sv.size();
+  _window_begin = _window_end = 0;
+  /* at most one offset per byte of a window */
+  _offsets.resize(min<size_t>(WINDOW_SIZE, _size + 64));
+  _count = _pos = 0;
+  _in_string = _escaped = 0;
+  _separated = 1;
+}
+
+void
+__structural_indexer::index_window()
+{
+  _window_begin = _window_end;
+  size_t len = min(WINDOW_SIZE, _size - _window_begin);
+  _window_end = _window_begin + len;
+  _count = 0;
+  _pos = 0;
+  uint32_t* out = _offsets.data();
+  for (size_t b=0; b<len; b+=64) {
+    const unsigned char* block = _data + _window_begin + b;
+    unsigned char tail[64];
+    if (len - b < 64) {
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, block, len - b);
+      block = tail;
+    }
+    __block_masks m;
+    _classify(block, m);
+    uint64_t quote = m.quote & ~__escaped_bytes(m.backslash, _escaped);
+    /* set from an opening quote up to, but excluding, the closing quote */
+    uint64_t in_string = __prefix_xor(quote) ^ _in_string;
+    _in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    assert_msg((m.control & in_string) == 0,
+               "unescaped control character in string at offset "
+               << _window_begin + b + __builtin_ctzll(m.control & in_string)
+               << ".");
+    uint64_t structural = m.structural & ~in_string;
+    uint64_t separator = structural | (m.whitespace & ~in_string) | quote;
+    /* first byte of every number or literal */
+    uint64_t scalar = ~(separator | in_string)
+                      & ((separator << 1) | _separated);
+    _separated = separator >> 63;
+    uint64_t bits = structural | quote | scalar;
+    while (bits) {
+      *out++ = b + __builtin_ctzll(bits);
+      bits &= bits - 1;
+    }
+  }
+  _count = out - _offsets.data();
+}
+
+static inline bool
+__is_strict_separator(const char* p, const char* end)
+{
+  return p == end || (__strict_char_class[static_cast<unsigned char>(*p)]
+                       & (__SC_QUOTE | __SC_STRUCTURAL | __SC_WHITESPACE));
+}
+
+/* the characters between a pair of quotes, decoded into scratch if they
+ * contain escape sequences */
+static string_view
+__retrieve_strict_string(const char* begin, const char* end, string& scratch)
+{
+  if (!memchr(begin, '\\', end - begin)) {
+    return string_view(begin, end - begin);
+  }
+  scratch.clear();
+  __unescape_string(begin, end, scratch, true);
+  return scratch;
+}
+
+template <typename H>
+static void
+__emit_strict_scalar(const char* begin, const char* end, size_t offset,
+                     H& handler)
+{
+  const char* p = begin;
+  size_t avail = end - p;
+  if (*p == 't' && avail >= 4 && memcmp(p, "true", 4) == 0) {
+    p += 4; handler.on_bool(true);
+  } else if (*p == 'f' && avail >= 5 && memcmp(p, "false", 5) == 0) {
+    p += 5; handler.on_bool(false);
+  } else if (*p == 'n' && avail >= 4 && memcmp(p, "null", 4) == 0) {
+    p += 4; handler.on_null();
+  } else {
+    des_number_t num;
+    assert_msg(__parse_json_number(begin, p, end, true, num),
+               "invalid number or literal at offset " << offset << ".");
+    assert_msg(__is_strict_separator(p, end), "unexpected character `" << *p
+               << "' at offset " << offset + (p - begin) << ".");
+    __emit_number(handler, num);
+    return;
+  }
+  assert_msg(__is_strict_separator(p, end), "unexpected character `" << *p
+             << "' at offset " << offset + (p - begin) << ".");
+}
+
+/* reads the quoted key at offset, the following colon, and advances offset
+ * to the value. */
+template <typename H>
+static void
+__read_strict_key(__structural_indexer& indexer, const char* data,
+                  size_t& offset, string& scratch, H& handler)
+{
+  assert_msg(data[offset] == '"',
+             "expecting object key at offset " << offset << ".");
+  size_t close = 0;
+  assert_msg(indexer.next(close), "missing closing quote character `\"'.");
+  string_view key = __retrieve_strict_string(data + offset + 1, data + close,
+                                             scratch);
+  assert_msg(indexer.next(offset) && data[offset] == ':',
+             "expecting `:' after object key at offset " << close << ".");
+  handler.on_key(key);
+  assert_msg(indexer.next(offset), "unexpected end of input.");
+}
+
+/* checks the escape sequences between a pair of quotes without decoding
+ * them */
+static void
+__check_strict_string(const char* begin, const char* end)
+{
+  __discarded_string none;
+  while (const char* bs = static_cast<const char*>(memchr(begin, '\\',
+                                                          end - begin))) {
+    begin = bs + 1;
+    __retrieve_escaped_string(begin, end, none, true);
+  }
+}
+
+/* checks the number at begin against the strict grammar without converting
+ * it; returns its end, or nullptr. Integers are still held to the int64
+ * range, as __parse_json_number() does.
+ */
+static const char*
+__check_strict_number(const char* begin, const char* end)
+{
+  auto skip_digits = [end](const char* p) {
+    while (p != end && static_cast<unsigned>(*p - '0') < 10) { ++ p; }
+    return p;
+  };
+  const char* digits = begin != end && *begin == '-' ? begin + 1 : begin;
+  const char* p = skip_digits(digits);
+  if (p == digits || (p - digits > 1 && *digits == '0')) { return nullptr; }
+  bool is_float = false;
+  if (p != end && *p == '.') {
+    const char* frac = p + 1;
+    p = skip_digits(frac);
+    if (p == frac) { return nullptr; }
+    is_float = true;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char* exp = p + 1;
+    if (exp != end && (*exp == '+' || *exp == '-')) { ++ exp; }
+    p = skip_digits(exp);
+    if (p == exp) { return nullptr; }
+    is_float = true;
+  }
+  if (!is_float && p - digits > 18) {
+    int64_t value = 0;
+    auto result = from_chars(begin, p, value);
+    assert_msg(result.ec == errc(), "integer `"
+               << string_view(begin, p - begin) << "' is out of range.");
+  }
+  return p;
+}
+
+static void
+__check_strict_scalar(const char* begin, const char* end, size_t offset)
+{
+  const char* p = begin;
+  size_t avail = end - p;
+  if (*p == 't' && avail >= 4 && memcmp(p, "true", 4) == 0) {
+    p += 4;
+  } else if (*p == 'f' && avail >= 5 && memcmp(p, "false", 5) == 0) {
+    p += 5;
+  } else if (*p == 'n' && avail >= 4 && memcmp(p, "null", 4) == 0) {
+    p += 4;
+  } else {
+    p = __check_strict_number(begin, end);
+    assert_msg(p, "invalid number or literal at offset " << offset << ".");
+  }
+  assert_msg(__is_strict_separator(p, end), "unexpected character `" << *p
+             << "' at offset " << offset + (p - begin) << ".");
+}
+
+/* __read_strict_key() for a key that is only validated */
+static void
+__skip_strict_key(__structural_indexer& indexer, const char* data,
+                  size_t& offset)
+{
+  assert_msg(data[offset] == '"',
+             "expecting object key at offset " << offset << ".");
+  size_t close = 0;
+  assert_msg(indexer.next(close), "missing closing quote character `\"'.");
+  __check_strict_string(data + offset + 1, data + close);
+  assert_msg(indexer.next(offset) && data[offset] == ':',
+             "expecting `:' after object key at offset " << close << ".");
+  assert_msg(indexer.next(offset), "unexpected end of input.");
+}
+
+/* Validates the value at offset as the stage two walk does, but hands out
+ * no events, so its strings and numbers are left undecoded. frames is the
+ * walk's own stack, which the value's containers are pushed onto.
+ */
+static void
+__skip_strict_value(__structural_indexer& indexer, const char* data,
+                    const char* end, size_t offset, vector<bool>& frames)
+{
+  size_t base = frames.size();
+  bool expect_value = true;
+  while (true) {
+    if (expect_value) {
+      char c = data[offset];
+      expect_value = false;
+      switch (c) {
+      case '{':
+      case '[':
+        {
+          bool is_object = c == '{';
+          assert_msg(indexer.next(offset), "unexpected end of input.");
+          if (data[offset] != (is_object ? '}' : ']')) {
+            frames.push_back(is_object);
+            if (is_object) { __skip_strict_key(indexer, data, offset); }
+            expect_value = true;
+          }
+        }
+        break;
+      case '"':
+        {
+          size_t close = 0;
+          assert_msg(indexer.next(close),
+                     "missing closing quote character `\"'.");
+          __check_strict_string(data + offset + 1, data + close);
+        }
+        break;
+      case '}': case ']': case ':': case ',':
+        assert_msg(0, "unexpected character `" << c << "' at offset "
+                      << offset << ".");
+        break;
+      default:
+        __check_strict_scalar(data + offset, end, offset);
+        break;
+      }
+      continue;
+    }
+    if (frames.size() == base) { return; }
+    assert_msg(indexer.next(offset), "unexpected end of input.");
+    char c = data[offset];
+    bool is_object = frames.back();
+    if (c == ',') {
+      assert_msg(indexer.next(offset), "unexpected end of input.");
+      if (is_object) { __skip_strict_key(indexer, data, offset); }
+      expect_value = true;
+    } else if (c == (is_object ? '}' : ']')) {
+      frames.pop_back();
+    } else {
+      assert_msg(0, "expecting `,' or `" << (is_object ? '}' : ']')
+                    << "' at offset " << offset << ".");
+    }
+  }
+}
+
+template <typename H> class __projection_filter;
+
+/* whether `H' is a projection, whose walk may skip values */
+template <typename H>
+struct __is_projection : false_type {};
+template <typename H>
+struct __is_projection<__projection_filter<H>> : true_type {};
+
+/* The stage two walk over the structural index of sv; `H' is the
+ * JsonHandler the events go to. With elements set, sv holds the comma
+ * separated elements of an array, without its brackets.
+ */
+template <typename H>
+static void
+__parse_json_strict(__structural_indexer& indexer, string_view sv,
+                    string& scratch, H& handler, bool elements = false)
+{
+  const char* data = sv.data();
+  const char* end  = data + sv.size();
+  vector<bool> frames;  /* true for objects */
+  size_t offset = 0;
+  if (elements) {
+    frames.push_back(false);
+    assert_msg(indexer.next(offset), "unexpected end of input.");
+  } else if (!indexer.next(offset)) {
+    return;
+  }
+  bool expect_value = true;
+  while (true) {
+    if (expect_value) {
+      char c = data[offset];
+      expect_value = false;
+      if constexpr (__is_projection<H>::value) {
+        if (!handler.wants_value(c)) {
+          __skip_strict_value(indexer, data, end, offset, frames);
+          handler.skip_value();
+          continue;
+        }
+      }
+      switch (c) {
+      case '{':
+      case '[':
+        {
+          bool is_object = c == '{';
+          frames.push_back(is_object);
+          if (is_object) { handler.on_object_begin(); }
+          else { handler.on_array_begin(); }
+          assert_msg(indexer.next(offset), "unexpected end of input.");
+          if (data[offset] == (is_object ? '}' : ']')) {
+            frames.pop_back();
+            if (is_object) { handler.on_object_end(); }
+            else { handler.on_array_end(); }
+          } else {
+            if (is_object) {
+              __read_strict_key(indexer, data, offset, scratch, handler);
+            }
+            expect_value = true;
+          }
+        }
+        break;
+      case '"':
+        {
+          size_t close = 0;
+          assert_msg(indexer.next(close),
+                     "missing closing quote character `\"'.");
+          handler.on_string(__retrieve_strict_string(data + offset + 1,
+                                                     data + close, scratch));
+        }
+        break;
+      case '}': case ']': case ':': case ',':
+        assert_msg(0, "unexpected character `" << c << "' at offset "
+                      << offset << ".");
+        break;
+      default:
+        __emit_strict_scalar(data + offset, end, offset, handler);
+        break;
+      }
+      continue;
+    }
+    if (frames.empty()) {
+      assert_msg(!indexer.next(offset), "unexpected trailing character `"
+                 << data[offset] << "' at offset " << offset << ".");
+      break;
+    }
+    if (!indexer.next(offset)) {
+      assert_msg(elements && frames.size() == 1, "unexpected end of input.");
+      break;
+    }
+    char c = data[offset];
+    bool is_object = frames.back();
+    assert_msg(!elements || frames.size() > 1 || c == ',',
+               "expecting `,' at offset " << offset << ".");
+    if (c == ',') {
+      assert_msg(indexer.next(offset), "unexpected end of input.");
+      if (is_object) {
+        __read_strict_key(indexer, data, offset, scratch, handler);
+      }
+      expect_value = true;
+    } else if (c == (is_object ? '}' : ']')) {
+      frames.pop_back();
+      if (is_object) { handler.on_object_end(); }
+      else { handler.on_array_end(); }
+    } else {
+      assert_msg(0, "expecting `,' or `" << (is_object ? '}' : ']')
+                    << "' at offset " << offset << ".");
+    }
+  }
+}
+
+template <typename H>
+static void
+__parse_json_strict(string_view sv, H& handler)
+{
+  __structural_indexer indexer(sv);
+  string scratch;
+  __parse_json_strict(indexer, sv, scratch, handler);
+}
+
+static void
+__skip_strict_spaces(des_buffer_t& buf)
+{
+  while (buf.cur != buf.end &&
+         (__strict_char_class[static_cast<unsigned char>(*buf.cur)]
+            & __SC_WHITESPACE)) {
+    ++ buf.cur;
+  }
+}
+
+/* __retrieve_quoted_string() for strict json, on a buffer positioned on the
+ * opening `"' */
+static string_view
+__retrieve_strict_quoted_string(des_buffer_t& buf, string& scratch)
+{
+  const char* begin = buf.cur + 1;
+  const char* delim = begin;
+  while (true) {
+    delim = __find_string_delimiter(delim, buf.end, '"');
+    if (delim != buf.end && *delim == '"') { break; }
+    /* steps over the backslash and the character it escapes */
+    if (buf.end - delim < 2) {
+      if (buf.partial) { throw __incomplete_input(); }
+      assert_msg(0, "missing closing quote character `\"'.");
+    }
+    delim += 2;
+  }
+  for (const char* p = begin; p != delim; ++ p) {
+    assert_msg(!(__strict_char_class[static_cast<unsigned char>(*p)]
+                 & __SC_CONTROL), "unescaped control character in string.");
+  }
+  buf.cur = delim + 1;
+  return __retrieve_strict_string(begin, delim, scratch);
+}
+
+/* The tokenizer of the push parser with strict_json, on the states of
+ * __parse_json5_token(): unlike the two stage parser, it sends the events of
+ * every chunk as they come. A comma is only consumed once the following
+ * token is in sight, so that trailing commas are rejected without a state
+ * of their own.
+ */
+template <typename H>
+static bool
+__parse_strict_token(des_buffer_t& buf, des_context_t& ctx, H& handler)
+{
+  __skip_strict_spaces(buf);
+  if (buf.eof()) { return false; }
+  char c = *buf.cur;
+  vector<JsonDeserializeState>& job_stack = ctx.job_stack;
+  JsonDeserializeState& state = job_stack.back();
+  switch (state) {
+  case JsonDeserializeState::OBJECT_KEY:
+    if (c == '}') {
+      ++ buf.cur; job_stack.pop_back();
+      handler.on_object_end();
+      break;
+    }
+    assert_msg(c == '"', "unexpected character `" << c
+               << "' in place of json object key.");
+    {
+      string_view key = __retrieve_strict_quoted_string(buf, ctx.scratch);
+      state = JsonDeserializeState::OBJECT_COLON;
+      handler.on_key(key);
+    }
+    break;
+  case JsonDeserializeState::OBJECT_COLON:
+    assert_msg(c == ':', "unexpected character `" << c
+               << "' in place of colon.");
+    ++ buf.cur;
+    state = JsonDeserializeState::OBJECT_VALUE;
+    break;
+  case JsonDeserializeState::OBJECT_COMMA:
+  case JsonDeserializeState::ARRAY_COMMA:
+    {
+      bool is_object = state == JsonDeserializeState::OBJECT_COMMA;
+      char close = is_object ? '}' : ']';
+      assert_msg(c == ',' || c == close, "unexpected character `" << c
+                 << "' after " << (is_object ? "value in json object."
+                                             : "entry in json array."));
+      if (c == close) {
+        ++ buf.cur; job_stack.pop_back();
+        if (is_object) { handler.on_object_end(); }
+        else { handler.on_array_end(); }
+        break;
+      }
+      des_buffer_t next = { buf.cur + 1, buf.end };
+      __skip_strict_spaces(next);
+      if (next.eof() && buf.partial) { throw __incomplete_input(); }
+      assert_msg(next.peek() != close, "unexpected trailing comma in json "
+                 << (is_object ? "object." : "array."));
+      ++ buf.cur;
+      state = is_object ? JsonDeserializeState::OBJECT_KEY
+                        : JsonDeserializeState::ARRAY_ENTRY;
+    }
+    break;
+  case JsonDeserializeState::ROOT_END:
+    assert_msg(0, "unexpected character `" << c << "' after the json value.");
+    break;
+  case JsonDeserializeState::ARRAY_ENTRY:
+    if (c == ']') {
+      ++ buf.cur; job_stack.pop_back();
+      handler.on_array_end();
+      break;
+    }
+    /* fall through */
+  default:
+    switch (c) {
+    case '{':
+      ++ buf.cur;
+      __complete_value(state);
+      job_stack.push_back(JsonDeserializeState::OBJECT_KEY);
+      handler.on_object_begin();
+      break;
+    case '[':
+      ++ buf.cur;
+      __complete_value(state);
+      job_stack.push_back(JsonDeserializeState::ARRAY_ENTRY);
+      handler.on_array_begin();
+      break;
+    case '"':
+      handler.on_string(__retrieve_strict_quoted_string(buf, ctx.scratch));
+      __complete_value(state);
+      break;
+    case '}': case ']': case ':': case ',':
+      assert_msg(0, "unexpected character `" << c
+                 << "' in place of json value.");
+      break;
+    default:
+      {
+        const char* begin = buf.cur;
+        while (!__is_strict_separator(buf.cur, buf.end)) { ++ buf.cur; }
+        if (buf.cur == buf.end && buf.partial) { throw __incomplete_input(); }
+        __emit_json_token(handler, begin, buf.cur, true);
+        __complete_value(state);
+      }
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// pull reader
+
+/* jumps over a quoted string without decoding it */
+static void
+__skip_quoted_string(des_buffer_t& buf)
+{
+  char open_quote = static_cast<char>(buf.get());
+  while (true) {
+    const char* delim = __find_string_delimiter(buf.cur, buf.end, open_quote);
+    assert_msg(delim != buf.end,
+               "missing closing quote character `" << open_quote << "'.");
+    buf.cur = delim + 1;
+    if (*delim == open_quote) { break; }
+    assert_msg(buf.cur != buf.end, "unexpected end of input in escape "
+                                   "sequence.");
+    ++ buf.cur;
+  }
+}
+
+#ifdef J5SERDES_X86_SIMD
+/* Bracket matching 32 bytes at a time. Brackets are counted with popcounts
+ * up to the first quote or slash of a block, and walked one by one only in
+ * a block where the depth may drop to zero. Stops on the quote or slash, on
+ * the close of the outermost value, or when less than 32 bytes are left.
+ */
+__attribute__((target("avx2,popcnt")))
+static void
+__skip_brackets_avx2(des_buffer_t& buf, size_t& depth)
+{
+  const __m256i open_brace  = _mm256_set1_epi8('{');
+  const __m256i close_brace = _mm256_set1_epi8('}');
+  const __m256i case_bit    = _mm256_set1_epi8(0x20);
+  const __m256i dquote      = _mm256_set1_epi8('"');
+  const __m256i squote      = _mm256_set1_epi8('\'');
+  const __m256i slash       = _mm256_set1_epi8('/');
+  while (buf.end - buf.cur >= 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf.cur));
+    /* '[' and ']' map onto '{' and '}' once the 0x20 bit is set */
+    __m256i lx = _mm256_or_si256(x, case_bit);
+    uint32_t open  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lx, open_brace));
+    uint32_t close = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lx, close_brace));
+    uint32_t stop  = _mm256_movemask_epi8(
+                       _mm256_or_si256(
+                         _mm256_or_si256(_mm256_cmpeq_epi8(x, dquote),
+                                         _mm256_cmpeq_epi8(x, squote)),
+                         _mm256_cmpeq_epi8(x, slash)));
+    uint32_t before_stop = stop ? (stop & (0 - stop)) - 1 : ~0u;
+    open &= before_stop;
+    close &= before_stop;
+    size_t n_close = __builtin_popcount(close);
+    if (depth > n_close) {
+      depth += __builtin_popcount(open) - n_close;
+    } else {
+      for (uint32_t bits = open | close; bits; bits &= bits - 1) {
+        unsigned i = __builtin_ctz(bits);
+        if ((open >> i) & 1) { ++ depth; }
+        else if (-- depth == 0) { buf.cur += i + 1; return; }
+      }
+    }
+    if (stop) { buf.cur += __builtin_ctz(stop); return; }
+    buf.cur += 32;
+  }
+}
+#endif
+
+/* skips to the close of the depth innermost arrays or objects */
+static void
+__skip_nested_values(des_buffer_t& buf, size_t depth)
+{
+#ifdef J5SERDES_X86_SIMD
+  static const bool has_avx2 = (__builtin_cpu_init(),
+                                __builtin_cpu_supports("avx2"));
+#endif
+  while (depth) {
+#ifdef J5SERDES_X86_SIMD
+    if (has_avx2) {
+      __skip_brackets_avx2(buf, depth);
+      if (!depth) { break; }
+    }
+#endif
+    assert_msg(buf.cur != buf.end, "unexpected end of input in json "
+                                   "array or object.");
+    switch (__json5_char_class[static_cast<unsigned char>(*buf.cur)]) {
+    case __CC_OBJECT_OPEN:
+    case __CC_ARRAY_OPEN:
+      ++ depth; ++ buf.cur;
+      break;
+    case __CC_OBJECT_CLOSE:
+    case __CC_ARRAY_CLOSE:
+      -- depth; ++ buf.cur;
+      break;
+    case __CC_QUOTE:
+      __skip_quoted_string(buf);
+      break;
+    case __CC_SLASH:
+      ++ buf.cur; __skip_comment(buf);
+      break;
+    default:
+      ++ buf.cur;
+    }
+  }
+}
+
+static void
+__skip_value(des_buffer_t& buf)
+{
+  __skip_no_parse(buf);
+  assert_msg(buf.cur != buf.end, "unexpected end of input in place of json "
+                                 "value.");
+  switch (__json5_char_class[static_cast<unsigned char>(*buf.cur)]) {
+  case __CC_OBJECT_OPEN:
+  case __CC_ARRAY_OPEN:
+    ++ buf.cur; __skip_nested_values(buf, 1);
+    break;
+  case __CC_QUOTE:
+    __skip_quoted_string(buf);
+    break;
+  case __CC_OTHER:
+    while (buf.cur != buf.end && !__is_scalar_end(*buf.cur)) { ++ buf.cur; }
+    break;
+  default:
+    assert_msg(0, "unexpected character `" << *buf.cur
+                  << "' in place of json value.");
+  }
+}
+
+/* The reader drives the json5 tokenizer one token at a time, with itself as
+ * the handler: each event only records the current token.
+ */
+class JsonReaderImpl final : public JsonReader {
+public:
+  explicit JsonReaderImpl(string_view sv)
+    : _buf({ sv.data(), sv.data() + sv.size() }), _token(Token::END),
+      _has_token(false), _flag(false) { _number.set(int64_t(0)); };
+
+  void on_object_begin() { set_token(Token::OBJECT_BEGIN); }
+  void on_object_end()   { set_token(Token::OBJECT_END); }
+  void on_array_begin()  { set_token(Token::ARRAY_BEGIN); }
+  void on_array_end()    { set_token(Token::ARRAY_END); }
+  void on_key(string_view key) { set_token(Token::KEY); _text = key; }
+  void on_string(string_view value)
+    { set_token(Token::STRING); _text = value; }
+  void on_number(double value)
+    { set_token(Token::NUMBER); _number.set(value); }
+  void on_integer(long long value)
+    { set_token(Token::NUMBER); _number.set(static_cast<int64_t>(value)); }
+  void on_bool(bool value) { set_token(Token::BOOL); _flag = value; }
+  void on_null() { set_token(Token::NULL_VALUE); }
+
+private:
+  Token            next();
+  Token            token() const { return _token; };
+  void             skip_value();
+
+  string_view      key() const;
+  string_view      string_value() const;
+  bool             is_integer() const;
+  double           number_value() const;
+  long long        integer_value() const;
+  bool             bool_value() const;
+
+  void             set_token(Token token)
+                     { _token = token; _has_token = true; };
+
+private:
+  des_buffer_t  _buf;
+  des_context_t _ctx;
+  Token         _token;
+  bool          _has_token;
+  string_view   _text;
+  des_number_t  _number;
+  bool          _flag;
+};
+
+JsonReader::Token
+JsonReaderImpl::next()
+{
+  _has_token = false;
+  while (!_has_token) {
+    if (!__parse_json5_token(_buf, _ctx, *this)) {
+      __finish_json5(_ctx);
+      _token = Token::END;
+      break;
+    }
+  }
+  return _token;
+}
+
+void
+JsonReaderImpl::skip_value()
+{
+  switch (_token) {
+  case Token::KEY:
+    /* a second call finds the value already skipped */
+    if (_ctx.job_stack.back() != JsonDeserializeState::OBJECT_COLON) { break; }
+    __skip_no_parse(_buf);
+    assert_msg(_buf.peek() == ':', "expecting colon after json object key.");
+    _buf.get();
+    __skip_value(_buf);
+    _ctx.job_stack.back() = JsonDeserializeState::OBJECT_COMMA;
+    break;
+  case Token::OBJECT_BEGIN:
+  case Token::ARRAY_BEGIN:
+    __skip_nested_values(_buf, 1);
+    _ctx.job_stack.pop_back();
+    _token = _token == Token::OBJECT_BEGIN ? Token::OBJECT_END
+                                           : Token::ARRAY_END;
+    break;
+  default:
+    break;
+  }
+}
+
+string_view
+JsonReaderImpl::key() const
+{
+  assert_msg(_token == Token::KEY, "the current token is not a key.");
+  return _text;
+}
+
+string_view
+JsonReaderImpl::string_value() const
+{
+  assert_msg(_token == Token::STRING, "the current token is not a string.");
+  return _text;
+}
+
+bool
+JsonReaderImpl::is_integer() const
+{
+  return _token == Token::NUMBER && _number.is_int;
+}
+
+double
+JsonReaderImpl::number_value() const
+{
+  assert_msg(_token == Token::NUMBER, "the current token is not a number.");
+  return _number.is_int ? static_cast<double>(_number.l) : _number.d;
+}
+
+long long
+JsonReaderImpl::integer_value() const
+{
+  assert_msg(_token == Token::NUMBER, "the current token is not a number.");
+  return _number.is_int ? _number.l : static_cast<long long>(_number.d);
+}
+
+bool
+JsonReaderImpl::bool_value() const
+{
+  assert_msg(_token == Token::BOOL, "the current token is not a boolean.");
+  return _flag;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// projections
+//
+// The paths of d_config_t::paths make a tree, walked along with the
+// document: a value is kept when its path ends at a leaf of the tree, or
+// when it is an array or an object on the way to one. Skipped values of the
+// json5 parser are jumped over by bracket matching; the strict parser still
+// reads them, but their events are dropped.
+
+struct __path_node {
+  vector<pair<string, unique_ptr<__path_node>>> children;
+  unique_ptr<__path_node> any;  /* `*' */
+  bool                    leaf = false;
+};
+
+static unique_ptr<__path_node>
+__make_projection(const vector<string>& paths)
+{
+  unique_ptr<__path_node> root = make_unique<__path_node>();
+  for (const string& path : paths) {
+    assert_msg(path.empty() || path[0] == '/',
+               "path `" << path << "' does not start with `/'.");
+    __path_node* node = root.get();
+    size_t pos = 0;
+    while (pos < path.size()) {
+      size_t next = path.find('/', pos + 1);
+      if (next == string::npos) { next = path.size(); }
+      string segment;
+      for (size_t i=pos+1; i<next; ++i) {
+        if (path[i] == '~' && i + 1 < next &&
+            (path[i + 1] == '0' || path[i + 1] == '1')) {
+          segment += path[++ i] == '0' ? '~' : '/';
+        } else {
+          segment += path[i];
+        }
+      }
+      unique_ptr<__path_node>* child = &node->any;
+      if (segment != "*") {
+        auto it = find_if(node->children.begin(), node->children.end(),
+                          [&segment](const auto& c)
+                            { return c.first == segment; });
+        if (it == node->children.end()) {
+          node->children.emplace_back(std::move(segment), nullptr);
+          it = node->children.end() - 1;
+        }
+        child = &it->second;
+      }
+      if (!*child) { *child = make_unique<__path_node>(); }
+      node = child->get();
+      pos = next;
+    }
+    node->leaf = true;
+  }
+  return root;
+}
+
+/* the node of the value at key in the array or object of node */
+static const __path_node*
+__path_child(const __path_node* node, string_view key)
+{
+  if (!node || node->leaf) { return node; }
+  for (const auto& child : node->children) {
+    if (child.first == key) { return child.second.get(); }
+  }
+  return node->any.get();
+}
+
+/* whether the value at node, starting with c, is kept */
+static inline bool
+__path_wants(const __path_node* node, char c)
+{
+  return node && (node->leaf || c == '{' || c == '[');
+}
+
+/* Forwards to `H' the events of the values kept by a projection. */
+template <typename H>
+class __projection_filter {
+public:
+  __projection_filter(const __path_node* root, H& handler)
+    : _handler(handler), _next(root) {};
+
+  /* whether the next value, starting with c, is kept */
+  bool wants_value(char c) { return __path_wants(value_node(), c); }
+  void skip_value()        { value_node(); advance(); }
+
+  void on_object_begin() { begin('{'); }
+  void on_object_end()   { end(); }
+  void on_array_begin()  { begin('['); }
+  void on_array_end()    { end(); }
+  void on_key(string_view key)
+  {
+    const __path_node* node = _frames.back().node;
+    _next = __path_child(node, key);
+    if (node && node->leaf) { _handler.on_key(key); }
+    else if (_next) { _key.assign(key.data(), key.size()); }
+  }
+  void on_string(string_view value)
+    { if (keep_scalar()) { _handler.on_string(value); } }
+  void on_number(double value)
+    { if (keep_scalar()) { _handler.on_number(value); } }
+  void on_integer(long long value)
+    { if (keep_scalar()) { _handler.on_integer(value); } }
+  void on_bool(bool value)
+    { if (keep_scalar()) { _handler.on_bool(value); } }
+  void on_null()
+    { if (keep_scalar()) { _handler.on_null(); } }
+
+private:
+  struct frame_t {
+    const __path_node* node;  /* nullptr for a dropped array or object */
+    bool               is_array;
+    size_t             index;
+  };
+
+  const __path_node* value_node()
+  {
+    if (!_frames.empty() && _frames.back().is_array) {
+      frame_t& frame = _frames.back();
+      char index[24];
+      char* end = to_chars(index, index + sizeof(index), frame.index).ptr;
+      _next = __path_child(frame.node, string_view(index, end - index));
+    }
+    return _next;
+  }
+  void advance()
+  {
+    if (!_frames.empty() && _frames.back().is_array) { ++ _frames.back().index; }
+    _next = nullptr;
+  }
+  /* the deferred key of a value kept in an object on the way to a leaf */
+  void forward_key()
+  {
+    if (!_frames.empty() && !_frames.back().is_array &&
+        !_frames.back().node->leaf) {
+      _handler.on_key(_key);
+    }
+  }
+  bool keep_scalar()
+  {
+    const __path_node* node = value_node();
+    advance();
+    if (!node || !node->leaf) { return false; }
+    forward_key();
+    return true;
+  }
+  void begin(char c)
+  {
+    const __path_node* node = value_node();
+    advance();
+    if (!__path_wants(node, c)) {
+      node = nullptr;
+    } else {
+      forward_key();
+      if (c == '{') { _handler.on_object_begin(); }
+      else { _handler.on_array_begin(); }
+    }
+    _frames.push_back({ node, c == '[', 0 });
+  }
+  void end()
+  {
+    frame_t frame = _frames.back();
+    _frames.pop_back();
+    if (!frame.node) { return; }
+    if (frame.is_array) { _handler.on_array_end(); }
+    else { _handler.on_object_end(); }
+  }
+
+  H&                 _handler;
+  vector<frame_t>    _frames;
+  const __path_node* _next;  /* the node of the next value of an object */
+  string             _key;
+};
+
+/* the json5 parser, skipping the values a projection does not keep */
+template <typename H>
+static void
+__parse_json5_projected(des_buffer_t& buf, __projection_filter<H>& filter)
+{
+  des_context_t ctx;
+  while (true) {
+    JsonDeserializeState& state = ctx.job_stack.back();
+    if (state == JsonDeserializeState::ROOT_VALUE ||
+        state == JsonDeserializeState::OBJECT_VALUE ||
+        state == JsonDeserializeState::ARRAY_ENTRY) {
+      __skip_no_parse(buf);
+      if (buf.cur != buf.end &&
+          (state != JsonDeserializeState::ARRAY_ENTRY ||
+           __json5_char_class[static_cast<unsigned char>(*buf.cur)]
+             != __CC_ARRAY_CLOSE) &&
+          !filter.wants_value(*buf.cur)) {
+        __skip_value(buf);
+        filter.skip_value();
+        __complete_value(state);
+        continue;
+      }
+    }
+    if (!__parse_json5_token(buf, ctx, filter)) { break; }
+  }
+  __finish_json5(ctx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// lazy documents
+//
+// A lazy document keeps its input, and every array or object is parsed one
+// level deep on first access: the members are only delimited by bracket
+// matching, and each of them becomes a record holding its text, to be parsed
+// in turn when it is accessed. Scalars are decoded on first access too.
+
+static JsonRecordPtr
+__make_lazy_record(const shared_ptr<const void>& input, const char* begin,
+                   const char* end)
+{
+  __lazy_text text{ input, begin, end };
+  switch (__json5_char_class[static_cast<unsigned char>(*begin)]) {
+  case __CC_OBJECT_OPEN:
+    return make_unique<JsonLazyObjectImpl>(std::move(text));
+  case __CC_ARRAY_OPEN:
+    return make_unique<JsonLazyArrayImpl>(std::move(text));
+  case __CC_QUOTE:
+    return make_unique<JsonLazyStringImpl>(std::move(text));
+  default:
+    return make_unique<JsonLazyDataImpl>(std::move(text));
+  }
+}
+
+/* delimits the value at buf, which is left after it */
+static JsonRecordPtr
+__make_lazy_member(const shared_ptr<const void>& input, des_buffer_t& buf)
+{
+  __skip_no_parse(buf);
+  const char* begin = buf.cur;
+  __skip_value(buf);
+  return __make_lazy_record(input, begin, buf.cur);
+}
+
+/* The members are gathered in a body of their own, only set once complete,
+ * by one of the threads accessing the object at once: the others then find
+ * it set. On failure the record stays unparsed, and fails again on the next
+ * access.
+ */
+const JsonObjectImpl::body_t*
+JsonLazyObjectImpl::load_body() const
+{
+  lock_guard<mutex> lock(__lazy_mutex(this));
+  if (const body_t* b = _body.get()) { return b; }
+  __body_ptr<body_t> body(new body_t());
+  des_buffer_t buf = { _text.begin + 1, _text.end };
+  string scratch;
+  while (true) {
+    __skip_no_parse(buf);
+    uint8_t cc = __json5_char_class[buf.peek() & 0xff];
+    if (cc == __CC_OBJECT_CLOSE) { break; }
+    assert_msg(!buf.eof() && (cc == __CC_QUOTE || cc == __CC_OTHER),
+               "expecting json object key.");
+    string_view key = cc == __CC_QUOTE
+                        ? __retrieve_quoted_string(buf, scratch)
+                        : __retrieve_unquoted_key(buf, scratch);
+    assert_msg(key.length(),
+               "unexpected non-json characters in json object key.");
+    __skip_no_parse(buf);
+    assert_msg(buf.get() == ':', "expecting colon after json object key.");
+    JsonRecordPtr member = __make_lazy_member(_text.input, buf);
+    emplace_member(*body, key, [&member]() { return std::move(member); });
+    __skip_no_parse(buf);
+    int c = buf.get();
+    if (c == '}') { break; }
+    assert_msg(c == ',', "expecting `,' or `}' in json object.");
+  }
+  _body.replace(std::move(body));
+  return _body.get();
+}
+
+/* an object still unparsed is cloned as such */
+JsonRecordPtr
+JsonLazyObjectImpl::clone() const
+{
+  if (!_body) { return make_unique<JsonLazyObjectImpl>(__lazy_text(_text)); }
+  return make_unique<JsonObjectImpl>(*this);
+}
+
+const JsonArrayImpl::body_t*
+JsonLazyArrayImpl::load_body() const
+{
+  lock_guard<mutex> lock(__lazy_mutex(this));
+  if (const body_t* b = _body.get()) { return b; }
+  __body_ptr<body_t> body(new body_t());
+  des_buffer_t buf = { _text.begin + 1, _text.end };
+  while (true) {
+    __skip_no_parse(buf);
+    if (buf.peek() == ']') { break; }
+    body->data.push_back(__make_lazy_member(_text.input, buf));
+    __skip_no_parse(buf);
+    int c = buf.get();
+    if (c == ']') { break; }
+    assert_msg(c == ',', "expecting `,' or `]' in json array.");
+  }
+  _body.replace(std::move(body));
+  return _body.get();
+}
+
+JsonRecordPtr
+JsonLazyArrayImpl::clone() const
+{
+  if (!_body) { return make_unique<JsonLazyArrayImpl>(__lazy_text(_text)); }
+  return make_unique<JsonArrayImpl>(*this);
+}
+
+const JsonDataImpl&
+JsonLazyDataImpl::value() const
+{
+  __load_once(this, _loaded, [this]() {
+    struct loader_t {
+      JsonDataImpl& data;
+      void on_null() { data._native_type = NativeType::NONE; }
+      void on_bool(bool value)
+        { data._native_type = NativeType::BOOL; data._content.l = value; }
+      void on_integer(long long value)
+        { data._native_type = NativeType::INT; data._content.l = value; }
+      void on_number(double value)
+        { data._native_type = NativeType::FLOAT; data._content.d = value; }
+    } loader = { _value };
+    __emit_json_token(loader, _text.begin, _text.end);
+  });
+  return _value;
+}
+
+const JsonDataImpl&
+JsonDataImpl::lazy_value() const
+{
+  return static_cast<const JsonLazyDataImpl*>(this)->value();
+}
+
+JsonRecordPtr
+JsonLazyDataImpl::clone() const
+{
+  if (_loaded.load(memory_order_acquire)) { return _value.clone(); }
+  return make_unique<JsonLazyDataImpl>(__lazy_text(_text));
+}
+
+void
+JsonLazyStringImpl::load() const
+{
+  __load_once(this, _loaded, [this]() {
+    des_buffer_t buf = { _text.begin, _text.end };
+    string scratch;
+    string_view value = __retrieve_quoted_string(buf, scratch);
+    string& content = const_cast<string&>(_content);
+    if (value.data() == scratch.data()) { content = std::move(scratch); }
+    else { content.assign(value.data(), value.size()); }
+  });
+}
+
+JsonRecordPtr
+JsonLazyStringImpl::clone() const
+{
+  if (_loaded.load(memory_order_acquire)) { return JsonStringImpl::clone(); }
+  return make_unique<JsonLazyStringImpl>(__lazy_text(_text));
+}
+
+/* Only the extent of the root value is checked up front; with strict_json
+ * the whole document is validated first.
+ */
+static JsonRecordPtr
+__make_lazy_document(const shared_ptr<const void>& input, string_view sv,
+                     const d_config_t& cfg)
+{
+  if (cfg.strict_json) {
+    JsonHandler validator;
+    __parse_json_strict(sv, validator);
+  }
+  des_buffer_t buf = { sv.data(), sv.data() + sv.size() };
+  __skip_no_parse(buf);
+  if (buf.eof()) { return JsonRecordPtr(); }
+  JsonRecordPtr ret = __make_lazy_member(input, buf);
+  __skip_no_parse(buf);
+  assert_msg(buf.eof(), "unexpected trailing character `" << *buf.cur
+             << "' after the json value.");
+  return ret;
+}
+
+static JsonRecordPtr
+__make_lazy_document(string&& doc, const d_config_t& cfg)
+{
+  shared_ptr<const string> input = make_shared<const string>(std::move(doc));
+  return __make_lazy_document(input, *input, cfg);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// push parser
+
+class JsonPushParserImpl final : public JsonPushParser {
+public:
+  JsonPushParserImpl(JsonHandler* handler, const d_config_t& cfg)
+    : _cfg(cfg), _builder(cfg), _handler(handler ? handler : &_builder),
+      _retry_size(0),
+      _finished(false) {};
+
+private:
+  void          feed(const char* data, size_t size);
+  JsonRecordPtr finish();
+
+  void          parse(des_buffer_t& buf);
+
+private:
+  d_config_t    _cfg;
+  __dom_builder _builder;
+  JsonHandler*  _handler;
+  des_context_t _ctx;
+  string        _pending;     /* unparsed tail of the chunks fed so far */
+  size_t        _retry_size;  /* _pending is parsed again at this size */
+  bool          _finished;
+};
+
+/* Parses the complete tokens of the buffer, leaving it at the start of the
+ * first incomplete one.
+ */
+void
+JsonPushParserImpl::parse(des_buffer_t& buf)
+{
+  while (true) {
+    const char* token = buf.cur;
+    try {
+      bool more = _cfg.strict_json
+                    ? __parse_strict_token(buf, _ctx, *_handler)
+                    : __parse_json5_token(buf, _ctx, *_handler);
+      if (!more) { break; }
+    } catch (const __incomplete_input&) {
+      buf.cur = token;
+      break;
+    }
+  }
+}
+
+/* A chunk is parsed in place; only the incomplete token at its end is copied
+ * and completed by the following chunks. A token spanning many chunks is
+ * retried only once the pending bytes have doubled, which keeps the work
+ * linear in its length.
+ */
+void
+JsonPushParserImpl::feed(const char* data, size_t size)
+{
+  assert_msg(!_finished, "the parser has already finished.");
+  if (_cfg.lazy && _handler == &_builder) {
+    /* lazy documents keep the whole input */
+    _pending.append(data, size);
+    return;
+  }
+  if (_pending.empty()) {
+    des_buffer_t buf = { data, data + size, true };
+    parse(buf);
+    _pending.assign(buf.cur, buf.end);
+  } else {
+    _pending.append(data, size);
+    if (_pending.size() < _retry_size) { return; }
+    des_buffer_t buf = { _pending.data(), _pending.data() + _pending.size(),
+                         true };
+    parse(buf);
+    _pending.erase(0, buf.cur - _pending.data());
+  }
+  _retry_size = 2 * _pending.size();
+}
+
+JsonRecordPtr
+JsonPushParserImpl::finish()
+{
+  assert_msg(!_finished, "the parser has already finished.");
+  _finished = true;
+  if (_cfg.lazy && _handler == &_builder) {
+    return __make_lazy_document(std::move(_pending), _cfg);
+  }
+  des_buffer_t buf = { _pending.data(), _pending.data() + _pending.size() };
+  if (_cfg.strict_json) {
+    while (__parse_strict_token(buf, _ctx, *_handler)) {}
+  } else {
+    while (__parse_json5_token(buf, _ctx, *_handler)) {}
+  }
+  __finish_json5(_ctx);
+  _pending.clear();
+  return _builder.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// document streams
+//
+// All the documents of a stream are parsed with the same context, builder
+// and structural indexer, so that their buffers are only allocated for the
+// first few documents. An istream is read in chunks, which are parsed in
+// place like those of a push parser.
+
+class JsonDocumentStreamImpl final : public JsonDocumentStream {
+public:
+  JsonDocumentStreamImpl(istream* istrm, string_view sv,
+                         const d_config_t& cfg);
+  JsonDocumentStreamImpl(unique_ptr<__file_view>&& file,
+                         const d_config_t& cfg);
+
+private:
+  JsonRecordPtr next();
+
+  bool          refill();
+  JsonRecordPtr next_json5();
+  JsonRecordPtr next_line();
+
+private:
+  static constexpr size_t CHUNK_SIZE = 65536;
+
+  d_config_t              _cfg;
+  istream*                _istrm;
+  unique_ptr<__file_view> _file;
+  string                  _chunk;  /* the unparsed input read from _istrm */
+  des_buffer_t            _buf;
+  des_context_t           _ctx;
+  __dom_builder           _builder;
+  __structural_indexer    _indexer;
+};
+
+JsonDocumentStreamImpl::JsonDocumentStreamImpl(istream* istrm, string_view sv,
+                                               const d_config_t& cfg)
+  : _cfg(cfg), _istrm(istrm),
+    _buf({ sv.data(), sv.data() + sv.size(), istrm != nullptr }),
+    _builder(cfg), _indexer(string_view())
+{
+  assert_msg(!cfg.lazy, "lazy documents are not supported by streams.");
+}
+
+JsonDocumentStreamImpl::JsonDocumentStreamImpl(unique_ptr<__file_view>&& file,
+                                               const d_config_t& cfg)
+  : JsonDocumentStreamImpl(nullptr, file->view(), cfg)
+{
+  _file = std::move(file);
+}
+
+/* Appends the next chunk of the istream to the unparsed input, reading at
+ * least as much as is left over so that a long token or line costs linear
+ * time. Returns false once the input is exhausted.
+ */
+bool
+JsonDocumentStreamImpl::refill()
+{
+  if (!_buf.partial) { return false; }
+  size_t pending = _buf.end - _buf.cur;
+  _chunk.erase(0, _chunk.size() - pending);
+  size_t size = max(CHUNK_SIZE, pending);
+  _chunk.resize(pending + size);
+  _istrm->read(&_chunk[pending], size);
+  _chunk.resize(pending + _istrm->gcount());
+  _buf = { _chunk.data(), _chunk.data() + _chunk.size(), _istrm->good() };
+  return true;
+}
+
+JsonRecordPtr
+JsonDocumentStreamImpl::next()
+{
+  return _cfg.strict_json ? next_line() : next_json5();
+}
+
+JsonRecordPtr
+JsonDocumentStreamImpl::next_json5()
+{
+  vector<JsonDeserializeState>& job_stack = _ctx.job_stack;
+  while (true) {
+    const char* token = _buf.cur;
+    try {
+      if (__parse_json5_token(_buf, _ctx, _builder)) {
+        if (job_stack.size() == 1 &&
+            job_stack[0] == JsonDeserializeState::ROOT_END) {
+          job_stack[0] = JsonDeserializeState::ROOT_VALUE;
+          return _builder.release();
+        }
+        continue;
+      }
+    } catch (const __incomplete_input&) {
+      _buf.cur = token;
+    }
+    if (!refill()) {
+      __finish_json5(_ctx);
+      return nullptr;
+    }
+  }
+}
+
+/* json lines: every line holds one document, and blank lines are skipped */
+JsonRecordPtr
+JsonDocumentStreamImpl::next_line()
+{
+  while (true) {
+    size_t size = _buf.end - _buf.cur;
+    const char* eol = size == 0 ? nullptr : static_cast<const char*>(
+                                    memchr(_buf.cur, '\n', size));
+    if (!eol) {
+      if (refill()) { continue; }
+      eol = _buf.end;
+    }
+    string_view line(_buf.cur, eol - _buf.cur);
+    _buf.cur = eol == _buf.end ? eol : eol + 1;
+    if (line.find_first_not_of(" \t\r") != string_view::npos) {
+      _indexer.reset(line);
+      __parse_json_strict(_indexer, line, _ctx.scratch, _builder);
+      return _builder.release();
+    }
+    if (eol == _buf.end && !_buf.partial) { return nullptr; }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// parallel json lines
+//
+// The workers take the chunks in input order, each parsing its chunk with a
+// document stream of its own. No more than a few chunks per worker are
+// parsed ahead of the consumer, which bounds the records held in memory
+// while the consumer lags behind, or waits for a slow chunk in ordered mode.
+
+/* splits sv into chunks of at least size bytes ending at a line break */
+static vector<string_view>
+__split_lines(string_view sv, size_t size)
+{
+  vector<string_view> chunks;
+  const char* cur = sv.data();
+  const char* end = cur + sv.size();
+  while (cur != end) {
+    const char* next = end;
+    if (static_cast<size_t>(end - cur) > size) {
+      const char* eol = static_cast<const char*>(
+                          memchr(cur + size, '\n', end - cur - size));
+      if (eol) { next = eol + 1; }
+    }
+    chunks.emplace_back(cur, next - cur);
+    cur = next;
+  }
+  return chunks;
+}
+
+struct __lines_chunk_t {
+  vector<JsonRecordPtr> records;
+  exception_ptr         error;
+  bool                  done = false;
+};
+
+static void
+__parse_json_lines(string_view sv, const JsonRecordConsumer& consumer,
+                   const d_config_t& cfg)
+{
+  assert_msg(!cfg.lazy, "lazy documents are not supported by streams.");
+  unsigned threads = cfg.threads ? cfg.threads
+                                 : max(1u, thread::hardware_concurrency());
+  /* small chunks keep the records in cache until they are passed on */
+  const size_t chunk_size = min<size_t>(max<size_t>(sv.size() / threads / 8,
+                                                    1 << 14), 1 << 16);
+  const vector<string_view> chunks = __split_lines(sv, chunk_size);
+  const size_t ahead = 4 * threads;
+
+  vector<__lines_chunk_t> results(chunks.size());
+  deque<size_t> done;  /* parsed chunks, in the order they completed */
+  size_t taken = 0, consumed = 0;
+  bool stop = false;
+  mutex mtx;
+  condition_variable ready, room;
+
+  auto work = [&]() {
+    while (true) {
+      size_t i;
+      {
+        unique_lock<mutex> lock(mtx);
+        room.wait(lock, [&]() {
+          return stop || taken == chunks.size() || taken < consumed + ahead;
+        });
+        if (stop || taken == chunks.size()) { return; }
+        i = taken++;
+      }
+      __lines_chunk_t& chunk = results[i];
+      try {
+        JsonDocumentStreamImpl impl(nullptr, chunks[i], cfg);
+        JsonDocumentStream& stream = impl;
+        while (JsonRecordPtr record = stream.next()) {
+          chunk.records.push_back(std::move(record));
+        }
+      } catch (...) {
+        chunk.error = current_exception();
+      }
+      {
+        lock_guard<mutex> lock(mtx);
+        chunk.done = true;
+        done.push_back(i);
+      }
+      ready.notify_one();
+    }
+  };
+
+  vector<thread> workers;
+  for (size_t i=0; i<min<size_t>(threads, chunks.size()); ++i) {
+    workers.emplace_back(work);
+  }
+  auto join = [&]() {
+    {
+      lock_guard<mutex> lock(mtx);
+      stop = true;
+    }
+    room.notify_all();
+    for (thread& worker : workers) { worker.join(); }
+  };
+
+  try {
+    for (size_t n=0; n<chunks.size(); ++n) {
+      size_t i = n;
+      {
+        unique_lock<mutex> lock(mtx);
+        if (cfg.ordered) {
+          ready.wait(lock, [&]() { return results[n].done; });
+        } else {
+          ready.wait(lock, [&]() { return !done.empty(); });
+          i = done.front();
+          done.pop_front();
+        }
+      }
+      __lines_chunk_t& chunk = results[i];
+      if (chunk.error) { rethrow_exception(chunk.error); }
+      for (JsonRecordPtr& record : chunk.records) {
+        consumer(std::move(record));
+      }
+      chunk.records = vector<JsonRecordPtr>();
+      {
+        lock_guard<mutex> lock(mtx);
+        ++consumed;
+      }
+      room.notify_all();
+    }
+  } catch (...) {
+    join();
+    throw;
+  }
+  join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// parallel array parsing
+//
+// A strict json document made of one large array is split into slices of
+// consecutive elements, parsed on one thread each. Split points are found
+// in two passes over the slices, on all threads. The first finds the parity
+// of the quotes of each slice, and its bracket depth change for either
+// string state at its start; their prefix sums give the string state and
+// the depth at the start of every slice. The second walks each slice from
+// its start to its first comma at depth one, outside of strings.
+
+/* Walks the structural characters of [begin, end) in order, passing each to
+ * f(p, in_string) with in_string telling whether it lies in a string when
+ * the walk starts outside of strings; f returns false to stop the walk.
+ * Returns whether a complete walk ends in a string.
+ */
+template <typename F>
+static bool
+__walk_structurals(const char* begin, const char* end, bool escaped, F&& f)
+{
+  static const __classify_fn classify = __select_classify_block();
+  uint64_t in_string_carry = 0;
+  uint64_t escape_carry = escaped;
+  for (const char* cur = begin; cur < end; cur += 64) {
+    const unsigned char* block = reinterpret_cast<const unsigned char*>(cur);
+    unsigned char tail[64];
+    if (end - cur < 64) {
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, block, end - cur);
+      block = tail;
+    }
+    __block_masks m;
+    classify(block, m);
+    uint64_t quote = m.quote & ~__escaped_bytes(m.backslash, escape_carry);
+    uint64_t in_string = __prefix_xor(quote) ^ in_string_carry;
+    in_string_carry = static_cast<uint64_t>(
+                        static_cast<int64_t>(in_string) >> 63);
+    for (uint64_t bits = m.structural; bits; bits &= bits - 1) {
+      int i = __builtin_ctzll(bits);
+      if (!f(cur + i, (in_string >> i) & 1)) { return false; }
+    }
+  }
+  return in_string_carry & 1;
+}
+
+/* runs f(0) to f(n - 1) on n threads, rethrowing the first error */
+template <typename F>
+static void
+__run_on_threads(size_t n, F&& f)
+{
+  vector<exception_ptr> errors(n);
+  auto run = [&f, &errors](size_t i) {
+    try { f(i); } catch (...) { errors[i] = current_exception(); }
+  };
+  vector<thread> workers;
+  for (size_t i=1; i<n; ++i) { workers.emplace_back(run, i); }
+  run(0);
+  for (thread& worker : workers) { worker.join(); }
+  for (exception_ptr& error : errors) {
+    if (error) { rethrow_exception(error); }
+  }
+}
+
+/* returns the offsets in [begin, end) of the commas to split the elements
+ * at, for slices of the given size */
+static vector<const char*>
+__find_array_splits(const char* begin, const char* end, size_t slice_size)
+{
+  size_t slices = (end - begin + slice_size - 1) / slice_size;
+  struct slice_t {
+    bool    parity;
+    int64_t depth_change[2];  /* starting outside, and inside a string */
+    bool    in_string;
+    int64_t depth;
+    const char* split;
+  };
+  vector<slice_t> state(slices);
+  auto slice_begin = [&](size_t i) { return begin + i * slice_size; };
+  auto slice_end   = [&](size_t i)
+    { return i + 1 == slices ? end : begin + (i + 1) * slice_size; };
+  auto escaped = [&](size_t i) {
+    size_t run = 0;
+    for (const char* p = slice_begin(i); p != begin && p[-1] == '\\'; --p) {
+      ++ run;
+    }
+    return (run & 1) == 1;
+  };
+
+  __run_on_threads(slices, [&](size_t i) {
+    int64_t change[2] = { 0, 0 };
+    state[i].parity = __walk_structurals(slice_begin(i), slice_end(i),
+                                         escaped(i),
+                                         [&change](const char* p, bool s) {
+      if (*p == '[' || *p == '{') { ++ change[s]; }
+      else if (*p == ']' || *p == '}') { -- change[s]; }
+      return true;
+    });
+    /* the brackets in strings when starting outside of one are those out of
+     * strings when starting inside */
+    state[i].depth_change[0] = change[0];
+    state[i].depth_change[1] = change[1];
+  });
+  bool in_string = false;
+  int64_t depth = 1;
+  for (slice_t& slice : state) {
+    slice.in_string = in_string;
+    slice.depth = depth;
+    depth += slice.depth_change[in_string];
+    in_string ^= slice.parity;
+  }
+  __run_on_threads(slices, [&](size_t i) {
+    state[i].split = nullptr;
+    if (i == 0) { return; }
+    int64_t depth = state[i].depth;
+    bool in_string = state[i].in_string;
+    __walk_structurals(slice_begin(i), slice_end(i), escaped(i),
+                       [&](const char* p, bool s) {
+      if (s != in_string) { return true; }
+      if (*p == '[' || *p == '{') { ++ depth; }
+      else if (*p == ']' || *p == '}') { -- depth; }
+      else if (*p == ',' && depth == 1) { state[i].split = p; return false; }
+      return true;
+    });
+  });
+
+  vector<const char*> splits;
+  for (slice_t& slice : state) {
+    if (slice.split) { splits.push_back(slice.split); }
+  }
+  return splits;
+}
+
+/* Returns nullptr unless sv holds one array large enough to be worth the
+ * threads. With arenas, the records of each thread are allocated from an
+ * arena added to them.
+ */
+static JsonRecordPtr
+__parse_json_array_parallel(string_view sv, const d_config_t& cfg,
+                            list<__arena>* arenas = nullptr)
+{
+  unsigned threads = cfg.threads ? cfg.threads
+                                 : max(1u, thread::hardware_concurrency());
+  const size_t min_slice_size = 1 << 20;
+  if (threads < 2 || sv.size() < 2 * min_slice_size) { return nullptr; }
+  const char* begin = sv.data();
+  const char* end   = begin + sv.size();
+  while (begin != end && __strict_char_class[
+                           static_cast<unsigned char>(*begin)]
+                         & __SC_WHITESPACE) {
+    ++ begin;
+  }
+  while (begin != end && __strict_char_class[
+                           static_cast<unsigned char>(end[-1])]
+                         & __SC_WHITESPACE) {
+    -- end;
+  }
+  if (end - begin < 2 || *begin != '[' || end[-1] != ']') { return nullptr; }
+
+  /* the elements, without the brackets */
+  ++ begin; -- end;
+  size_t slice_size = max<size_t>((end - begin + threads - 1) / threads,
+                                  min_slice_size);
+  vector<const char*> splits = __find_array_splits(begin, end, slice_size);
+  if (splits.empty()) { return nullptr; }
+
+  /* one pool for the whole document, rather than one per slice */
+  d_config_t part_cfg = cfg;
+  if (cfg.intern_strings && !cfg.string_pool) {
+    part_cfg.string_pool = make_json_string_pool();
+  }
+  vector<JsonRecordPtr> parts(splits.size() + 1);
+  vector<__arena*> part_arenas(parts.size());
+  for (size_t i=0; arenas && i<parts.size(); ++i) {
+    part_arenas[i] = &arenas->emplace_back();
+  }
+  __run_on_threads(parts.size(), [&](size_t i) {
+    const char* part_begin = i == 0 ? begin : splits[i - 1] + 1;
+    const char* part_end   = i == splits.size() ? end : splits[i];
+    string_view part(part_begin, part_end - part_begin);
+    __structural_indexer indexer(part);
+    __dom_builder builder(part_cfg, part_arenas[i]);
+    string scratch;
+    builder.on_array_begin();
+    __parse_json_strict(indexer, part, scratch, builder, true);
+    builder.on_array_end();
+    parts[i] = builder.release();
+  });
+  vector<JsonArrayImpl*> tails;
+  for (size_t i=1; i<parts.size(); ++i) {
+    tails.push_back(static_cast<JsonArrayImpl*>(parts[i].get()));
+  }
+  static_cast<JsonArrayImpl*>(parts[0].get())->splice(tails);
+  return std::move(parts[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename H>
+static void
+__parse_json(string_view sv, H& handler, const d_config_t& cfg)
+{
+  if (!cfg.paths.empty()) {
+    unique_ptr<__path_node> root = __make_projection(cfg.paths);
+    __projection_filter<H> filter(root.get(), handler);
+    if (cfg.strict_json) { __parse_json_strict(sv, filter); return; }
+    des_buffer_t buf = { sv.data(), sv.data() + sv.size() };
+    __parse_json5_projected(buf, filter);
+    return;
+  }
+  if (cfg.strict_json) { __parse_json_strict(sv, handler); return; }
+  des_buffer_t buf = { sv.data(), sv.data() + sv.size() };
+  __parse_json5(buf, handler);
+}
+
+template <typename H>
+static void
+__parse_json(istream& istrm, H& handler, const d_config_t& cfg)
+{
+  if (cfg.strict_json || !cfg.paths.empty()) {
+    /* the two stage parser and the projections need the whole document at
+     * hand */
+    string doc(istreambuf_iterator<char>(istrm), {});
+    __parse_json(string_view(doc), handler, cfg);
+    return;
+  }
+  __parse_json5(istrm, handler);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// documents
+
+class JsonDocumentImpl final : public JsonDocument {
+public:
+  JsonDocumentImpl() : _arenas(1) {};
+
+  /* parses sv into the root */
+  void parse(string_view sv, const d_config_t& cfg);
+
+  template <typename T, typename... Args>
+  unique_ptr<T> create(Args&&... args)
+  {
+    return unique_ptr<T>(
+             __new_arena_record<T>(_arenas.front(), forward<Args>(args)...));
+  };
+
+private:
+  JsonRecordPtr&    root() { return _root; };
+  const JsonRecord* root() const { return _root.get(); };
+
+  JsonObjectPtr     make_object() { return create<JsonObjectImpl>(); };
+  JsonArrayPtr      make_array() { return create<JsonArrayImpl>(); };
+  JsonDataPtr       make_data() { return create<JsonDataImpl>(); };
+  JsonStringPtr     make_string(string_view value)
+                      { return create<JsonStringImpl>(value); };
+
+private:
+  list<__arena> _arenas;  /* the first one for the records made one by one */
+  /* deleted first, destroying the records before their arenas are freed */
+  JsonRecordPtr _root;
+};
+
+void
+JsonDocumentImpl::parse(string_view sv, const d_config_t& cfg)
+{
+  assert_msg(!cfg.lazy, "lazy documents are not supported by JsonDocument.");
+  if (cfg.parallel && cfg.strict_json && cfg.paths.empty()) {
+    _root = __parse_json_array_parallel(sv, cfg, &_arenas);
+    if (_root) { return; }
+  }
+  __dom_builder builder(cfg, &_arenas.front());
+  __parse_json(sv, builder, cfg);
+  _root = builder.release();
+}
+
+template<typename T>
+JsonDataPtr
+JsonDocument::make_data(T value)
+{
+  return static_cast<JsonDocumentImpl*>(this)->create<JsonDataImpl>(value);
+}
+
+template JsonDataPtr
+JsonDocument::make_data<bool>(bool);
+template JsonDataPtr
+JsonDocument::make_data<double>(double);
+template JsonDataPtr
+JsonDocument::make_data<int64_t>(int64_t);
+template JsonDataPtr
+JsonDocument::make_data<uint64_t>(uint64_t);
+template JsonDataPtr
+JsonDocument::make_data<int>(int);
+template JsonDataPtr
+JsonDocument::make_data<unsigned>(unsigned);
+
+////////////////////////////////////////////////////////////////////////////////
+// tapes
+
+// A word of a tape holds a tag in its top byte, and a payload below it:
+//   '{' '['  the index of the word closing the array or object
+//   '}' ']'  the number of members or elements
+//   '"'      the offset in the string buffer of a 32-bit length, followed by
+//            the content; keys are strings too, each followed by its value
+//   'l' 'd'  nothing; the next word holds an int64 or the bits of a double
+//   'n' 't' 'f'  nothing
+
+static constexpr uint64_t __TAPE_PAYLOAD_MASK = (1ull << 56) - 1;
+
+static inline uint64_t
+__tape_word(char tag, uint64_t payload)
+{
+  return static_cast<uint64_t>(static_cast<uint8_t>(tag)) << 56 | payload;
+}
+
+static inline char
+__tape_tag(uint64_t word)
+{
+  return static_cast<char>(word >> 56);
+}
+
+static inline uint64_t
+__tape_payload(uint64_t word)
+{
+  return word & __TAPE_PAYLOAD_MASK;
+}
+
+class JsonTapeImpl final : public JsonTape {
+public:
+  /* parses the input, a string_view or an istream, into the tape */
+  template <typename In>
+  void          parse(In& input, const d_config_t& cfg);
+
+  JsonTapeValue root() const { return JsonTapeValue(this, 0); };
+  size_t        memory_usage() const
+                  { return _words.capacity() * sizeof(uint64_t)
+                           + _strings.capacity(); };
+
+  uint64_t      word(size_t i) const { return _words[i]; };
+  string_view   string_at(size_t i) const;
+  /* the index of the word after the value at i */
+  size_t        skip(size_t i) const;
+
+private:
+  friend class __tape_builder;
+
+  vector<uint64_t> _words;
+  string           _strings;
+};
+
+string_view
+JsonTapeImpl::string_at(size_t i) const
+{
+  const char* p = _strings.data() + __tape_payload(_words[i]);
+  uint32_t size;
+  memcpy(&size, p, sizeof(size));
+  return string_view(p + sizeof(size), size);
+}
+
+size_t
+JsonTapeImpl::skip(size_t i) const
+{
+  switch (__tape_tag(_words[i])) {
+  case '{': case '[':
+    return __tape_payload(_words[i]) + 1;
+  case 'l': case 'd':
+    return i + 2;
+  default:
+    return i + 1;
+  }
+}
+
+/* Appends the parser events to a tape. The index of the opening word of each
+ * array and object is kept until it is closed, along with its size so far.
+ * As in JsonObject, the first of duplicate keys wins: a later one is dropped
+ * along with its value.
+ */
+class __tape_builder final : public JsonHandler {
+public:
+  explicit __tape_builder(JsonTapeImpl& tape)
+    : _tape(tape), _words(tape._words), _strings(tape._strings) {};
+
+  void on_object_begin() { if (!dropped(1)) { open('{'); } }
+  void on_object_end()   { if (!dropped(-1)) { close('}'); } }
+  void on_array_begin()  { if (!dropped(1)) { open('['); } }
+  void on_array_end()    { if (!dropped(-1)) { close(']'); } }
+  void on_key(string_view key)
+  {
+    if (dropped(0)) { return; }
+    if (holds_key(key)) { _dropping = true; return; }
+    append_string(key);
+    index_key();
+  }
+  void on_string(string_view value)
+  {
+    if (dropped(0)) { return; }
+    count();
+    append_string(value);
+  }
+  void on_number(double value)
+  {
+    if (dropped(0)) { return; }
+    count();
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    _words.push_back(__tape_word('d', 0));
+    _words.push_back(bits);
+  }
+  void on_integer(long long value)
+  {
+    if (dropped(0)) { return; }
+    count();
+    _words.push_back(__tape_word('l', 0));
+    _words.push_back(static_cast<uint64_t>(value));
+  }
+  void on_bool(bool value)
+  {
+    if (dropped(0)) { return; }
+    count();
+    _words.push_back(__tape_word(value ? 't' : 'f', 0));
+  }
+  void on_null()
+    { if (!dropped(0)) { count(); _words.push_back(__tape_word('n', 0)); } }
+
+private:
+  /* Keys are found with an index in objects of INDEX_THRESHOLD members or
+   * more, and by a walk over the tape in smaller ones, as in JsonObject.
+   */
+  static constexpr size_t INDEX_THRESHOLD = 16;
+
+  struct index_slot_t {
+    size_t hash;  /* 0 in empty slots */
+    size_t word;  /* the index of the key in the tape */
+  };
+
+  struct frame_t {
+    size_t begin;
+    size_t size;
+    /* open addressing with linear probing, at most half full */
+    vector<index_slot_t> index;
+  };
+
+  /* true if the event is part of a dropped value; depth is 1 for the
+   * beginning of an array or object, -1 for its end, 0 otherwise */
+  bool dropped(int depth)
+  {
+    if (!_dropping) { return false; }
+    _drop_depth += depth;
+    _dropping = _drop_depth != 0;
+    return true;
+  }
+  /* whether the innermost object holds key already */
+  bool holds_key(string_view key) const;
+  /* indexes the key just appended to the innermost object */
+  void index_key();
+  static void insert_slot(vector<index_slot_t>& index, size_t hash,
+                          size_t word);
+
+  void count() { if (!_frames.empty()) { ++ _frames.back().size; } }
+  void open(char tag)
+  {
+    count();
+    _frames.push_back({ _words.size(), 0, {} });
+    _words.push_back(__tape_word(tag, 0));
+  }
+  void close(char tag)
+  {
+    _words[_frames.back().begin] |= _words.size();
+    _words.push_back(__tape_word(tag, _frames.back().size));
+    _frames.pop_back();
+  }
+  void append_string(string_view sv)
+  {
+    assert_msg(sv.size() <= UINT32_MAX,
+               "string of " << sv.size() << " bytes is too long for a tape.");
+    uint32_t size = static_cast<uint32_t>(sv.size());
+    _words.push_back(__tape_word('"', _strings.size()));
+    _strings.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    _strings.append(sv.data(), sv.size());
+  }
+
+  JsonTapeImpl&     _tape;
+  vector<frame_t>   _frames;
+  vector<uint64_t>& _words;
+  string&           _strings;
+  bool              _dropping = false;
+  long              _drop_depth = 0;
+};
+
+bool
+__tape_builder::holds_key(string_view key) const
+{
+  const frame_t& frame = _frames.back();
+  if (frame.index.empty()) {
+    size_t i = frame.begin + 1;
+    for (size_t n = 0; n < frame.size; ++ n, i = _tape.skip(i + 1)) {
+      if (_tape.string_at(i) == key) { return true; }
+    }
+    return false;
+  }
+  size_t hash = __member_hash(key), mask = frame.index.size() - 1;
+  for (size_t i = hash & mask; frame.index[i].hash; i = (i + 1) & mask) {
+    if (frame.index[i].hash == hash
+        && _tape.string_at(frame.index[i].word) == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+__tape_builder::index_key()
+{
+  frame_t& frame = _frames.back();
+  size_t keys = frame.size + 1;
+  if (frame.index.empty() ? keys < INDEX_THRESHOLD
+                          : 2 * keys <= frame.index.size()) {
+    if (!frame.index.empty()) {
+      size_t word = _words.size() - 1;
+      insert_slot(frame.index, __member_hash(_tape.string_at(word)), word);
+    }
+    return;
+  }
+  /* (re)builds the index over all the keys, the last one included */
+  size_t capacity = 2 * INDEX_THRESHOLD;
+  while (capacity < 4 * keys) { capacity *= 2; }
+  frame.index.assign(capacity, { 0, 0 });
+  size_t i = frame.begin + 1;
+  for (size_t n = 0; n < keys; ++ n) {
+    insert_slot(frame.index, __member_hash(_tape.string_at(i)), i);
+    if (n + 1 < keys) { i = _tape.skip(i + 1); }
+  }
+}
+
+void
+__tape_builder::insert_slot(vector<index_slot_t>& index, size_t hash,
+                            size_t word)
+{
+  size_t mask = index.size() - 1, i;
+  for (i = hash & mask; index[i].hash; i = (i + 1) & mask) {}
+  index[i] = { hash, word };
+}
+
+template <typename In>
+void
+JsonTapeImpl::parse(In& input, const d_config_t& cfg)
+{
+  assert_msg(!cfg.lazy, "lazy documents are not supported by JsonTape.");
+  __tape_builder builder(*this);
+  __parse_json(input, builder, cfg);
+  assert_msg(!_words.empty(), "the document holds no value.");
+  /* the tape is never appended to again */
+  _words.shrink_to_fit();
+  _strings.shrink_to_fit();
+}
+
+static inline const JsonTapeImpl&
+__tape_impl(const JsonTape* tape)
+{
+  return *static_cast<const JsonTapeImpl*>(tape);
+}
+
+JsonRecord::Type
+JsonTapeValue::type() const
+{
+  switch (__tape_tag(__tape_impl(_tape).word(_index))) {
+  case '{':
+    return JsonRecord::Type::OBJECT;
+  case '[':
+    return JsonRecord::Type::ARRAY;
+  case '"':
+    return JsonRecord::Type::STRING;
+  default:
+    return JsonRecord::Type::DATA;
+  }
+}
+
+bool
+JsonTapeValue::is_null() const
+{
+  return __tape_tag(__tape_impl(_tape).word(_index)) == 'n';
+}
+
+bool
+JsonTapeValue::as_bool() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  switch (__tape_tag(tape.word(_index))) {
+  case 'n': case 'f':
+    return false;
+  case 't':
+    return true;
+  case 'l':
+    return tape.word(_index + 1) != 0;
+  case 'd':
+    return as_double() != 0.;
+  case '"':
+    return tape.string_at(_index) == "true"
+           || tape.string_at(_index) == "True";
+  default:
+    assert_msg(0, "not allowed on array or object value.");
+  }
+  return false;
+}
+
+double
+JsonTapeValue::as_double() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  switch (__tape_tag(tape.word(_index))) {
+  case 'n': case 'f':
+    return 0.;
+  case 't':
+    return 1.;
+  case 'l':
+    return static_cast<double>(static_cast<int64_t>(tape.word(_index + 1)));
+  case 'd':
+    {
+      uint64_t bits = tape.word(_index + 1);
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  case '"':
+    return stod(string(tape.string_at(_index)));
+  default:
+    assert_msg(0, "not allowed on array or object value.");
+  }
+  return 0.;
+}
+
+long long
+JsonTapeValue::as_int() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  switch (__tape_tag(tape.word(_index))) {
+  case 'l':
+    return static_cast<long long>(tape.word(_index + 1));
+  case 'd':
+    return static_cast<long long>(as_double());
+  case '"':
+    return stoll(string(tape.string_at(_index)));
+  default:
+    return static_cast<long long>(as_double());
+  }
+}
+
+unsigned long long
+JsonTapeValue::as_unsigned() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  switch (__tape_tag(tape.word(_index))) {
+  case 'l':
+    return static_cast<unsigned long long>(tape.word(_index + 1));
+  case 'd':
+    return static_cast<uint64_t>(as_double());
+  case '"':
+    return stoull(string(tape.string_at(_index)));
+  default:
+    return static_cast<unsigned long long>(as_double());
+  }
+}
+
+string_view
+JsonTapeValue::string_value() const
+{
+  assert_msg(type() == JsonRecord::Type::STRING,
+             "not allowed on non-string value.");
+  return __tape_impl(_tape).string_at(_index);
+}
+
+string
+JsonTapeValue::to_string() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  switch (__tape_tag(tape.word(_index))) {
+  case 'n':
+    return "null";
+  case 't':
+    return "true";
+  case 'f':
+    return "false";
+  case 'l':
+    return std::to_string(static_cast<int64_t>(tape.word(_index + 1)));
+  case 'd':
+    return std::to_string(as_double());
+  case '"':
+    return string(tape.string_at(_index));
+  default:
+    assert_msg(0, "not allowed on array or object value.");
+  }
+  return string();
+}
+
+JsonTapeValue::const_iterator
+JsonTapeValue::begin() const
+{
+  char tag = __tape_tag(__tape_impl(_tape).word(_index));
+  assert_msg(tag == '{' || tag == '[',
+             "not allowed on non-array, non-object value.");
+  return const_iterator(_tape, _index + 1, tag == '{');
+}
+
+JsonTapeValue::const_iterator
+JsonTapeValue::end() const
+{
+  uint64_t word = __tape_impl(_tape).word(_index);
+  char tag = __tape_tag(word);
+  assert_msg(tag == '{' || tag == '[',
+             "not allowed on non-array, non-object value.");
+  return const_iterator(_tape, __tape_payload(word), tag == '{');
+}
+
+JsonTapeValue::const_iterator
+JsonTapeValue::find(string_view key) const
+{
+  assert_msg(type() == JsonRecord::Type::OBJECT,
+             "not allowed on non-object value.");
+  const_iterator it = begin(), it_end = end();
+  for (; it != it_end && it.key() != key; ++ it) {}
+  return it;
+}
+
+JsonTapeValue
+JsonTapeValue::at(string_view key) const
+{
+  const_iterator it = find(key);
+  assert_msg(it != end(), "key `" << key << "' is not found.");
+  return *it;
+}
+
+JsonTapeValue
+JsonTapeValue::at(size_t i) const
+{
+  assert_msg(type() == JsonRecord::Type::ARRAY,
+             "not allowed on non-array value.");
+  assert_msg(i < size(), "index " << i << " is out of range.");
+  const_iterator it = begin();
+  for (; i; -- i) { ++ it; }
+  return *it;
+}
+
+size_t
+JsonTapeValue::count(string_view key) const
+{
+  return find(key) != end() ? 1 : 0;
+}
+
+bool
+JsonTapeValue::empty() const
+{
+  return size() == 0;
+}
+
+size_t
+JsonTapeValue::size() const
+{
+  const JsonTapeImpl& tape = __tape_impl(_tape);
+  uint64_t word = tape.word(_index);
+  char tag = __tape_tag(word);
+  assert_msg(tag == '{' || tag == '[',
+             "not allowed on non-array, non-object value.");
+  return __tape_payload(tape.word(__tape_payload(word)));
+}
+
+string_view
+JsonTapeValue::const_iterator::key() const
+{
+  assert_msg(_in_object, "not allowed on array elements.");
+  return __tape_impl(_tape).string_at(_index);
+}
+
+JsonTapeValue::const_iterator&
+JsonTapeValue::const_iterator::operator++()
+{
+  _index = __tape_impl(_tape).skip(value());
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// values
+
+// The low three bits of the tag of a JsonValue hold its kind, and the high
+// five bits the size of an inline string. The payloads are stored at the
+// start of the storage, and copied in and out with memcpy().
+
+static_assert(sizeof(JsonValue) == 16, "JsonValue is not 16 bytes.");
+
+enum class __value_kind : uint8_t {
+  NONE = 0,
+  BOOL,
+  INT,
+  FLOAT,
+  INLINE_STRING,
+  STRING,
+  ARRAY,
+  OBJECT,
+};
+
+static constexpr size_t __VALUE_INLINE_SIZE = 15;
+
+template <typename T>
+static inline T
+__value_load(const char* storage)
+{
+  T ret;
+  memcpy(&ret, storage, sizeof(T));
+  return ret;
+}
+
+template <typename T>
+static inline void
+__value_store(char* storage, T payload)
+{
+  memcpy(storage, &payload, sizeof(T));
+}
+
+uint8_t
+JsonValue::kind() const
+{
+  return _tag & 7;
+}
+
+#define __VALUE_KIND(k) static_cast<uint8_t>(__value_kind::k)
+
+JsonValue::JsonValue(JsonRecord::Type type) : _storage(), _tag(0)
+{
+  switch (type) {
+  case JsonRecord::Type::OBJECT:
+    __value_store(_storage, new object_type());
+    _tag = __VALUE_KIND(OBJECT);
+    break;
+  case JsonRecord::Type::ARRAY:
+    __value_store(_storage, new array_type());
+    _tag = __VALUE_KIND(ARRAY);
+    break;
+  case JsonRecord::Type::STRING:
+    _tag = __VALUE_KIND(INLINE_STRING);
+    break;
+  default:
+    break;
+  }
+}
+
+JsonValue::JsonValue(bool value) : _storage(), _tag(__VALUE_KIND(BOOL))
+{
+  _storage[0] = value ? 1 : 0;
+}
+
+JsonValue::JsonValue(double value) : _storage(), _tag(__VALUE_KIND(FLOAT))
+{
+  __value_store(_storage, value);
+}
+
+JsonValue::JsonValue(int64_t value) : _storage(), _tag(__VALUE_KIND(INT))
+{
+  __value_store(_storage, value);
+}
+
+JsonValue::JsonValue(uint64_t value)
+  : JsonValue(static_cast<int64_t>(value))
+{}
+
+JsonValue::JsonValue(int value) : JsonValue(static_cast<int64_t>(value))
+{}
+
+JsonValue::JsonValue(unsigned value) : JsonValue(static_cast<int64_t>(value))
+{}
+
+JsonValue::JsonValue(string_view value) : _storage()
+{
+  if (value.size() <= __VALUE_INLINE_SIZE) {
+    memcpy(_storage, value.data(), value.size());
+    _tag = __VALUE_KIND(INLINE_STRING) | value.size() << 3;
+  } else {
+    __value_store(_storage, new string(value));
+    _tag = __VALUE_KIND(STRING);
+  }
+}
+
+JsonValue::JsonValue(array_type&& value)
+  : _storage(), _tag(__VALUE_KIND(ARRAY))
+{
+  __value_store(_storage, new array_type(std::move(value)));
+}
+
+JsonValue::JsonValue(object_type&& value)
+  : _storage(), _tag(__VALUE_KIND(OBJECT))
+{
+  __value_store(_storage, new object_type(std::move(value)));
+}
+
+static inline bool
+__is_container(const JsonValue& value)
+{
+  JsonRecord::Type type = value.type();
+  return type == JsonRecord::Type::ARRAY || type == JsonRecord::Type::OBJECT;
+}
+
+/* Copies the array or object src into dst. Nested arrays and objects are
+ * copied one at a time from a stack, rather than recursively, which deeply
+ * nested documents would overflow: each is first made empty in its parent,
+ * and filled once popped.
+ */
+static void
+__copy_nested_values(JsonValue& dst, const JsonValue& src)
+{
+  vector<pair<JsonValue*, const JsonValue*>> pending;
+  auto copy = [](const JsonValue& from) {
+    if (!__is_container(from)) { return JsonValue(from); }
+    return JsonValue(from.type());
+  };
+  auto push = [&pending](JsonValue& to, const JsonValue& from) {
+    if (__is_container(from) && !from.empty()) {
+      pending.emplace_back(&to, &from);
+    }
+  };
+  dst = JsonValue(src.type());
+  pending.emplace_back(&dst, &src);
+  while (!pending.empty()) {
+    JsonValue& to = *pending.back().first;
+    const JsonValue& from = *pending.back().second;
+    pending.pop_back();
+    /* reserved first, so that the pointers pushed stay valid */
+    if (from.type() == JsonRecord::Type::ARRAY) {
+      JsonValue::array_type& values = to.as_array();
+      values.reserve(from.as_array().size());
+      for (const JsonValue& v : from.as_array()) {
+        values.push_back(copy(v));
+        push(values.back(), v);
+      }
+    } else {
+      JsonValue::object_type& members = to.as_object();
+      members.reserve(from.as_object().size());
+      for (const JsonValue::member_type& m : from.as_object()) {
+        members.emplace_back(m.first, copy(m.second));
+        push(members.back().second, m.second);
+      }
+    }
+  }
+}
+
+JsonValue::JsonValue(const JsonValue& src) : _storage(), _tag(src._tag)
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::STRING:
+    __value_store(_storage,
+                  new string(*__value_load<string*>(src._storage)));
+    break;
+  case __value_kind::ARRAY:
+  case __value_kind::OBJECT:
+    _tag = 0;
+    __copy_nested_values(*this, src);
+    break;
+  default:
+    memcpy(_storage, src._storage, sizeof(_storage));
+  }
+}
+
+JsonValue::JsonValue(JsonValue&& src) noexcept : _tag(src._tag)
+{
+  memcpy(_storage, src._storage, sizeof(_storage));
+  src._tag = 0;
+}
+
+JsonValue&
+JsonValue::operator=(const JsonValue& src)
+{
+  if (this != &src) { *this = JsonValue(src); }
+  return *this;
+}
+
+JsonValue&
+JsonValue::operator=(JsonValue&& src) noexcept
+{
+  if (this != &src) {
+    release();
+    memcpy(_storage, src._storage, sizeof(_storage));
+    _tag = src._tag;
+    src._tag = 0;
+  }
+  return *this;
+}
+
+JsonValue::~JsonValue()
+{
+  release();
+}
+
+/* Moves the arrays and objects held by value to pending, so that freeing
+ * the value frees no nested container.
+ */
+static void
+__unlink_nested_values(JsonValue& value, JsonValue::array_type& pending)
+{
+  auto unlink = [&pending](JsonValue& v) {
+    JsonRecord::Type type = v.type();
+    if (type == JsonRecord::Type::ARRAY || type == JsonRecord::Type::OBJECT) {
+      pending.push_back(std::move(v));
+    }
+  };
+  if (value.type() == JsonRecord::Type::ARRAY) {
+    for (JsonValue& v : value.as_array()) { unlink(v); }
+  } else {
+    for (JsonValue::member_type& m : value.as_object()) { unlink(m.second); }
+  }
+}
+
+/* Nested arrays and objects are freed one at a time from a stack, rather than
+ * recursively, which deeply nested documents would overflow.
+ */
+void
+JsonValue::release() noexcept
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::STRING:
+    delete __value_load<string*>(_storage);
+    break;
+  case __value_kind::ARRAY:
+  case __value_kind::OBJECT:
+    {
+      array_type pending;
+      __unlink_nested_values(*this, pending);
+      if (kind() == __VALUE_KIND(ARRAY)) {
+        delete __value_load<array_type*>(_storage);
+      } else {
+        delete __value_load<object_type*>(_storage);
+      }
+      while (!pending.empty()) {
+        JsonValue v = std::move(pending.back());
+        pending.pop_back();
+        __unlink_nested_values(v, pending);
+      }
+    }
+    break;
+  default:
+    break;
+  }
+  _tag = 0;
+}
+
+JsonRecord::Type
+JsonValue::type() const
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return JsonRecord::Type::STRING;
+  case __value_kind::ARRAY:
+    return JsonRecord::Type::ARRAY;
+  case __value_kind::OBJECT:
+    return JsonRecord::Type::OBJECT;
+  default:
+    return JsonRecord::Type::DATA;
+  }
+}
+
+bool
+JsonValue::is_null() const
+{
+  return kind() == __VALUE_KIND(NONE);
+}
+
+bool
+JsonValue::as_bool() const
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::NONE:
+    return false;
+  case __value_kind::BOOL:
+    return _storage[0] != 0;
+  case __value_kind::INT:
+    return __value_load<int64_t>(_storage) != 0;
+  case __value_kind::FLOAT:
+    return __value_load<double>(_storage) != 0.;
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return string_value() == "true" || string_value() == "True";
+  default:
+    assert_msg(0, "not allowed on array or object value.");
+  }
+  return false;
+}
+
+double
+JsonValue::as_double() const
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::NONE:
+    return 0.;
+  case __value_kind::BOOL:
+    return _storage[0] ? 1. : 0.;
+  case __value_kind::INT:
+    return static_cast<double>(__value_load<int64_t>(_storage));
+  case __value_kind::FLOAT:
+    return __value_load<double>(_storage);
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return stod(string(string_value()));
+  default:
+    assert_msg(0, "not allowed on array or object value.");
   }
+  return 0.;
 }
 
-void
-handle_object_open(istream& istrm, const d_config_t& cfg,
-                   std::stack<des_job_state_t>& job_stack,
-                   JsonRecordPtr& root_record)
-{
-  assert_msg(istrm.peek() == '{', "expecting opening curly brace.");
-  istrm.get();  /* consume the opening curly brace */
-  unique_ptr<JsonObjectImpl> ret = make_unique<JsonObjectImpl>();
-  des_job_state_t* active_job = nullptr;
-  if (!job_stack.empty()) active_job = &(job_stack.top());
-  job_stack.push({ JsonDeserializeState::OBJECT_KEY, ret.get(), string() });
-  if (active_job) {
-    switch (active_job->state) {
-    case JsonDeserializeState::OBJECT_VALUE:
-      static_cast<JsonObject*>(active_job->record)
-        ->insert(active_job->active_key, std::move(ret));
-      active_job->state = JsonDeserializeState::OBJECT_COMMA;
-      break;
-    case JsonDeserializeState::ARRAY_ENTRY:
-      static_cast<JsonArray*>(active_job->record)
-        ->push_back(std::move(ret));
-      active_job->state = JsonDeserializeState::ARRAY_COMMA;
-      break;
-    default:
-      assert_msg(0, "unexpected state.");
-    }
-  } else {
-    root_record = std::move(ret);
+long long
+JsonValue::as_int() const
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::INT:
+    return __value_load<int64_t>(_storage);
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return stoll(string(string_value()));
+  default:
+    return static_cast<long long>(as_double());
   }
 }
 
-void
-handle_array_close(istream& istrm, const d_config_t& cfg,
-                   std::stack<des_job_state_t>& job_stack,
-                   JsonRecordPtr& root_record)
+unsigned long long
+JsonValue::as_unsigned() const
 {
-  assert_msg(istrm.peek() == ']', "expecting closing square bracket.");
-  istrm.get();  /* consume the closing square bracket */
-  assert_msg(!job_stack.empty(), "unexpected closing square bracket outside of "
-                                 "array.");
-  auto& active_job = job_stack.top();
-  assert_msg(active_job.state == JsonDeserializeState::ARRAY_ENTRY ||
-             active_job.state == JsonDeserializeState::ARRAY_COMMA,
-             "unexpected closing square bracket in json array.");
-  job_stack.pop();
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::INT:
+    return __value_load<uint64_t>(_storage);
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return stoull(string(string_value()));
+  default:
+    return static_cast<uint64_t>(as_double());
+  }
 }
 
-void
-handle_object_close(istream& istrm, const d_config_t& cfg,
-                    std::stack<des_job_state_t>& job_stack,
-                    JsonRecordPtr& root_record)
+string_view
+JsonValue::string_value() const
+{
+  if (kind() == __VALUE_KIND(INLINE_STRING)) {
+    return string_view(_storage, _tag >> 3);
+  }
+  assert_msg(kind() == __VALUE_KIND(STRING),
+             "not allowed on non-string value.");
+  return *__value_load<string*>(_storage);
+}
+
+string
+JsonValue::to_string() const
+{
+  switch (static_cast<__value_kind>(kind())) {
+  case __value_kind::NONE:
+    return "null";
+  case __value_kind::BOOL:
+    return _storage[0] ? "true" : "false";
+  case __value_kind::INT:
+    return std::to_string(__value_load<int64_t>(_storage));
+  case __value_kind::FLOAT:
+    return std::to_string(__value_load<double>(_storage));
+  case __value_kind::INLINE_STRING:
+  case __value_kind::STRING:
+    return string(string_value());
+  default:
+    assert_msg(0, "not allowed on array or object value.");
+  }
+  return string();
+}
+
+JsonValue::array_type&
+JsonValue::as_array()
+{
+  assert_msg(kind() == __VALUE_KIND(ARRAY), "not allowed on non-array value.");
+  return *__value_load<array_type*>(_storage);
+}
+
+const JsonValue::array_type&
+JsonValue::as_array() const
+{
+  return const_cast<JsonValue*>(this)->as_array();
+}
+
+JsonValue::object_type&
+JsonValue::as_object()
+{
+  assert_msg(kind() == __VALUE_KIND(OBJECT),
+             "not allowed on non-object value.");
+  return *__value_load<object_type*>(_storage);
+}
+
+const JsonValue::object_type&
+JsonValue::as_object() const
+{
+  return const_cast<JsonValue*>(this)->as_object();
+}
+
+JsonValue::object_type::iterator
+JsonValue::find(string_view key)
+{
+  object_type& obj = as_object();
+  return find_if(obj.begin(), obj.end(),
+                 [key](const member_type& m) { return m.first == key; });
+}
+
+JsonValue::object_type::const_iterator
+JsonValue::find(string_view key) const
+{
+  return const_cast<JsonValue*>(this)->find(key);
+}
+
+JsonValue&
+JsonValue::at(string_view key)
+{
+  auto it = find(key);
+  assert_msg(it != as_object().end(), "key `" << key << "' is not found.");
+  return it->second;
+}
+
+const JsonValue&
+JsonValue::at(string_view key) const
+{
+  return const_cast<JsonValue*>(this)->at(key);
+}
+
+JsonValue&
+JsonValue::operator[](string_view key)
+{
+  auto it = find(key);
+  if (it != as_object().end()) { return it->second; }
+  return as_object().emplace_back(key, JsonValue()).second;
+}
+
+size_t
+JsonValue::erase(string_view key)
+{
+  auto it = find(key);
+  if (it == as_object().end()) { return 0; }
+  as_object().erase(it);
+  return 1;
+}
+
+size_t
+JsonValue::count(string_view key) const
+{
+  return find(key) != as_object().end() ? 1 : 0;
+}
+
+JsonValue&
+JsonValue::at(size_t i)
 {
-  assert_msg(istrm.peek() == '}', "expecting closing curly brace.");
-  istrm.get();  /* consume the closing curly brace */
-  assert_msg(!job_stack.empty(), "unexpected closing curly brace outside of "
-                                 "object.");
-  auto& active_job = job_stack.top();
-  assert_msg(active_job.state == JsonDeserializeState::OBJECT_KEY ||
-             active_job.state == JsonDeserializeState::OBJECT_COMMA,
-             "unexpected closing curly brace in json object.");
-  job_stack.pop();
+  array_type& arr = as_array();
+  assert_msg(i < arr.size(), "index " << i << " is out of range.");
+  return arr[i];
 }
 
+const JsonValue&
+JsonValue::at(size_t i) const
+{
+  return const_cast<JsonValue*>(this)->at(i);
+}
+
+bool
+JsonValue::empty() const
+{
+  return size() == 0;
+}
+
+size_t
+JsonValue::size() const
+{
+  if (kind() == __VALUE_KIND(ARRAY)) { return as_array().size(); }
+  assert_msg(kind() == __VALUE_KIND(OBJECT),
+             "not allowed on non-array, non-object value.");
+  return as_object().size();
+}
+
+#undef __VALUE_KIND
+
+/* Builds a JsonValue from the parser events. The elements and members of
+ * the open arrays and objects are staged on two stacks shared by all of
+ * them, and moved into a container of the exact size once it is closed.
+ * As in JsonObject, the first of duplicate keys wins: the later members are
+ * dropped when their object is closed.
+ */
+class __value_builder final : public JsonHandler {
+public:
+  void on_object_begin() { open(true); }
+  void on_object_end()   { close(); }
+  void on_array_begin()  { open(false); }
+  void on_array_end()    { close(); }
+  void on_key(string_view key) { _key.assign(key.data(), key.size()); }
+  void on_string(string_view value) { attach(JsonValue(value)); }
+  void on_number(double value) { attach(JsonValue(value)); }
+  void on_integer(long long value)
+    { attach(JsonValue(static_cast<int64_t>(value))); }
+  void on_bool(bool value) { attach(JsonValue(value)); }
+  void on_null() { attach(JsonValue()); }
+
+  JsonValue release() { return std::move(_root); }
+
+private:
+  struct frame_t {
+    size_t begin;      /* of the staged elements or members */
+    bool   is_object;
+    string key;        /* of the array or object in its parent */
+  };
+
+  void attach(JsonValue&& value)
+  {
+    if (_frames.empty()) {
+      _root = std::move(value);
+    } else if (_frames.back().is_object) {
+      _members.emplace_back(std::move(_key), std::move(value));
+    } else {
+      _values.push_back(std::move(value));
+    }
+  }
+  void open(bool is_object)
+  {
+    _frames.push_back({ is_object ? _members.size() : _values.size(),
+                        is_object, std::move(_key) });
+  }
+  void close()
+  {
+    frame_t& frame = _frames.back();
+    JsonValue container;
+    if (frame.is_object) {
+      drop_duplicate_members(frame.begin);
+      auto begin = _members.begin() + frame.begin;
+      container = JsonValue::object_type(make_move_iterator(begin),
+                                         make_move_iterator(_members.end()));
+      _members.erase(begin, _members.end());
+    } else {
+      auto begin = _values.begin() + frame.begin;
+      container = JsonValue::array_type(make_move_iterator(begin),
+                                        make_move_iterator(_values.end()));
+      _values.erase(begin, _values.end());
+    }
+    _key = std::move(frame.key);
+    _frames.pop_back();
+    attach(std::move(container));
+  }
+  void drop_duplicate_members(size_t begin);
+
+  vector<frame_t>                _frames;
+  JsonValue::array_type          _values;
+  JsonValue::object_type         _members;
+  string                         _key;
+  JsonValue                      _root;
+};
+
+/* Small objects are searched for duplicates pairwise, larger ones with a
+ * set of their keys; the staged members are only moved if there are any.
+ */
 void
-handle_object_key(istream& istrm, const d_config_t& cfg,
-                  std::stack<des_job_state_t>& job_stack,
-                  JsonRecordPtr& root_record)
-{
-  assert_msg(!job_stack.empty(), "unexpected object key outside of "
-                                 "object.");
-  auto& active_job = job_stack.top();
-  assert_msg(active_job.state == JsonDeserializeState::OBJECT_KEY,
-             "unexpected object key in json object.");
-  char c = istrm.peek();
-  if (c == '"' || c == '\'') {
-    active_job.active_key = __retrieve_quoted_string(istrm);
+__value_builder::drop_duplicate_members(size_t begin)
+{
+  static constexpr size_t SCAN_THRESHOLD = 16;
+  size_t n = _members.size() - begin;
+  vector<bool> dropped(n);
+  bool any = false;
+  if (n < SCAN_THRESHOLD) {
+    for (size_t i = 1; i < n; ++ i) {
+      const string& key = _members[begin + i].first;
+      size_t j = 0;
+      for (; j < i && _members[begin + j].first != key; ++ j) {}
+      dropped[i] = j < i;
+      any = any || j < i;
+    }
   } else {
-    active_job.active_key.clear();
-    while (istrm && !istrm.eof()) {
-      c = istrm.peek();
-      if (std::isspace(c) || c == ':' || c == ',' || c == '}') { break; }
-      active_job.active_key += static_cast<char>(istrm.get());
+    unordered_set<string_view> keys(2 * n);
+    for (size_t i = 0; i < n; ++ i) {
+      dropped[i] = !keys.insert(_members[begin + i].first).second;
+      any = any || dropped[i];
     }
   }
-  assert_msg(active_job.active_key.length(),
-             "unexpected non-json characters in json object key.");
-  active_job.state = JsonDeserializeState::OBJECT_COLON;
+  if (!any) { return; }
+  size_t end = begin;
+  for (size_t i = 0; i < n; ++ i) {
+    if (dropped[i]) { continue; }
+    if (end != begin + i) { _members[end] = std::move(_members[begin + i]); }
+    ++ end;
+  }
+  _members.erase(_members.begin() + end, _members.end());
+}
+
+template <typename In>
+static JsonValue
+__make_json_value(In& input, const d_config_t& cfg)
+{
+  assert_msg(!cfg.lazy, "lazy documents are not supported by JsonValue.");
+  __value_builder builder;
+  __parse_json(input, builder, cfg);
+  return builder.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// reclamation
+
+class JsonReclaimerImpl final : public JsonReclaimer {
+public:
+  JsonReclaimerImpl();
+  ~JsonReclaimerImpl();
+
+private:
+  void   retire(JsonRecordPtr&&);
+  void   drain();
+  size_t pending() const;
+
+  void   run();
+
+  mutable mutex         _mutex;
+  condition_variable    _wakeup;    /* records retired, or stopping */
+  condition_variable    _deleted;   /* a batch deleted */
+  vector<JsonRecordPtr> _queue;
+  size_t                _n_retired;
+  size_t                _n_deleted;
+  bool                  _stop;
+  thread                _thread;
+};
+
+JsonReclaimerImpl::JsonReclaimerImpl()
+  : _n_retired(0), _n_deleted(0), _stop(false),
+    _thread(&JsonReclaimerImpl::run, this)
+{}
+
+JsonReclaimerImpl::~JsonReclaimerImpl()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wakeup.notify_one();
+  _thread.join();
 }
 
 void
-handle_comma(istream& istrm, const d_config_t& cfg,
-             std::stack<des_job_state_t>& job_stack,
-             JsonRecordPtr& root_record)
-{
-  assert_msg(istrm.peek() == ',', "expecting comma.");
-  istrm.get();  /* consume the comma */
-  assert_msg(!job_stack.empty(), "unexpected comma outside of "
-                                 "array or object.");
-  auto& active_job = job_stack.top();
-  switch (active_job.state) {
-  case JsonDeserializeState::ARRAY_COMMA:
-    active_job.state = JsonDeserializeState::ARRAY_ENTRY;
-    break;
-  case JsonDeserializeState::OBJECT_COMMA:
-    active_job.state = JsonDeserializeState::OBJECT_KEY;
-    break;
-  default:
-    assert_msg(0, "unexpected state.");
-  };
+JsonReclaimerImpl::retire(JsonRecordPtr&& record)
+{
+  if (!record) { return; }
+  {
+    lock_guard<mutex> lock(_mutex);
+    _queue.push_back(std::move(record));
+    ++ _n_retired;
+  }
+  _wakeup.notify_one();
 }
 
 void
-handle_colon(istream& istrm, const d_config_t& cfg,
-             std::stack<des_job_state_t>& job_stack,
-             JsonRecordPtr& root_record)
+JsonReclaimerImpl::drain()
+{
+  unique_lock<mutex> lock(_mutex);
+  size_t target = _n_retired;
+  _deleted.wait(lock, [this, target]() { return _n_deleted >= target; });
+}
+
+size_t
+JsonReclaimerImpl::pending() const
 {
-  assert_msg(istrm.peek() == ':', "expecting colon.");
-  istrm.get();  /* consume the colon */
-  assert_msg(!job_stack.empty(), "unexpected colon outside of "
-                                 "object.");
-  auto& active_job = job_stack.top();
-  assert_msg(active_job.state == JsonDeserializeState::OBJECT_COLON,
-             "unexpected colon in json object.");
-  active_job.state = JsonDeserializeState::OBJECT_VALUE;
+  lock_guard<mutex> lock(_mutex);
+  return _n_retired - _n_deleted;
 }
 
+/* Takes all the records retired so far at once, and deletes them with the
+ * lock released.
+ */
 void
-handle_scalar(istream& istrm, const d_config_t& cfg,
-              std::stack<des_job_state_t>& job_stack,
-              JsonRecordPtr& root_record)
-{
-  JsonRecordPtr ret = make_json_scalar(istrm, cfg);
-  des_job_state_t* active_job = nullptr;
-  if (!job_stack.empty()) { active_job = &(job_stack.top()); }
-  if (active_job) {
-    switch (active_job->state) {
-    case JsonDeserializeState::ARRAY_ENTRY:
-      static_cast<JsonArray*>(active_job->record)->push_back(std::move(ret));
-      active_job->state = JsonDeserializeState::ARRAY_COMMA;
-      break;
-    case JsonDeserializeState::OBJECT_VALUE:
-      static_cast<JsonObject*>(active_job->record)
-        ->insert(active_job->active_key, std::move(ret));
-      active_job->state = JsonDeserializeState::OBJECT_COMMA;
-      break;
-    default:
-      assert_msg(0, "unexpected state.");
-    }
-  } else {
-    root_record = std::move(ret);
+JsonReclaimerImpl::run()
+{
+#ifdef __linux__
+  /* on linux, sets the nice value of the calling thread only */
+  setpriority(PRIO_PROCESS, 0, 19);
+#endif
+  vector<JsonRecordPtr> batch;
+  unique_lock<mutex> lock(_mutex);
+  while (true) {
+    _wakeup.wait(lock, [this]() { return _stop || !_queue.empty(); });
+    if (_queue.empty()) { return; }
+    batch.swap(_queue);
+    lock.unlock();
+    size_t n = batch.size();
+    batch.clear();
+    lock.lock();
+    _n_deleted += n;
+    _deleted.notify_all();
   }
 }
 
-static const unordered_map<char, function<void(istream&, const d_config_t&,
-                                               std::stack<des_job_state_t>&,
-                                               JsonRecordPtr&)>>
-__des_handlers = {
-    { '{', handle_object_open },
-    { '[', handle_array_open },
-    { ']', handle_array_close },
-    { '}', handle_object_close },
-    { ':', handle_colon },
-    { ',', handle_comma }
-  };
+////////////////////////////////////////////////////////////////////////////////
 
 JsonRecordPtr
 make_json_record(istream& istrm, const d_config_t& cfg)
 {
-  __skip_no_parse(istrm);
-  JsonRecordPtr ret;
-  if (istrm.eof()) { return ret; }
-  std::stack<des_job_state_t> job_stack;
-  while (istrm && !istrm.eof()) {
-    __skip_no_parse(istrm);
-    if (istrm.eof()) { break; }
-    char c = istrm.peek();
-    auto it = __des_handlers.find(c);
-    if (it != __des_handlers.end()) {
-      it->second(istrm, cfg, job_stack, ret);
-    } else {
-      if (!job_stack.empty() &&
-          job_stack.top().state == JsonDeserializeState::OBJECT_KEY)
-      { handle_object_key(istrm, cfg, job_stack, ret); }
-      else { handle_scalar(istrm, cfg, job_stack, ret); }
-    }
+  if (cfg.lazy) {
+    return __make_lazy_document(string(istreambuf_iterator<char>(istrm), {}),
+                                cfg);
   }
-  return ret;
+  __dom_builder builder(cfg);
+  __parse_json(istrm, builder, cfg);
+  return builder.release();
+}
+
+JsonRecordPtr
+make_json_record(string_view sv, const d_config_t& cfg)
+{
+  if (cfg.lazy) { return __make_lazy_document(string(sv), cfg); }
+  if (cfg.parallel && cfg.strict_json && cfg.paths.empty()) {
+    JsonRecordPtr ret = __parse_json_array_parallel(sv, cfg);
+    if (ret) { return ret; }
+  }
+  __dom_builder builder(cfg);
+  __parse_json(sv, builder, cfg);
+  return builder.release();
+}
+
+JsonRecordPtr
+make_json_record(const char* data, size_t size, const d_config_t& cfg)
+{
+  return make_json_record(string_view(data, size), cfg);
+}
+
+JsonRecordPtr
+make_json_record_from_file(const string& path, const d_config_t& cfg)
+{
+  if (cfg.lazy) {
+    /* the records refer to the mapped file directly */
+    shared_ptr<const __file_view> file = make_shared<__file_view>(path);
+    return __make_lazy_document(file, file->view(), cfg);
+  }
+  __file_view file(path);
+  return make_json_record(file.view(), cfg);
+}
+
+JsonDocumentPtr
+make_json_document()
+{
+  return make_unique<JsonDocumentImpl>();
+}
+
+JsonDocumentPtr
+make_json_document(string_view sv, const d_config_t& cfg)
+{
+  unique_ptr<JsonDocumentImpl> doc = make_unique<JsonDocumentImpl>();
+  doc->parse(sv, cfg);
+  return doc;
+}
+
+JsonDocumentPtr
+make_json_document_from_file(const string& path, const d_config_t& cfg)
+{
+  __file_view file(path);
+  return make_json_document(file.view(), cfg);
+}
+
+JsonTapePtr
+make_json_tape(istream& istrm, const d_config_t& cfg)
+{
+  unique_ptr<JsonTapeImpl> tape = make_unique<JsonTapeImpl>();
+  tape->parse(istrm, cfg);
+  return tape;
+}
+
+JsonTapePtr
+make_json_tape(string_view sv, const d_config_t& cfg)
+{
+  unique_ptr<JsonTapeImpl> tape = make_unique<JsonTapeImpl>();
+  tape->parse(sv, cfg);
+  return tape;
+}
+
+JsonTapePtr
+make_json_tape_from_file(const string& path, const d_config_t& cfg)
+{
+  __file_view file(path);
+  return make_json_tape(file.view(), cfg);
+}
+
+JsonValue
+make_json_value(istream& istrm, const d_config_t& cfg)
+{
+  return __make_json_value(istrm, cfg);
+}
+
+JsonValue
+make_json_value(string_view sv, const d_config_t& cfg)
+{
+  return __make_json_value(sv, cfg);
+}
+
+JsonValue
+make_json_value_from_file(const string& path, const d_config_t& cfg)
+{
+  __file_view file(path);
+  return make_json_value(file.view(), cfg);
+}
+
+JsonReclaimerPtr
+make_json_reclaimer()
+{
+  return make_unique<JsonReclaimerImpl>();
+}
+
+void
+parse_json_events(istream& istrm, JsonHandler& handler, const d_config_t& cfg)
+{
+  __parse_json(istrm, handler, cfg);
+}
+
+void
+parse_json_events(string_view sv, JsonHandler& handler, const d_config_t& cfg)
+{
+  __parse_json(sv, handler, cfg);
+}
+
+JsonPushParserPtr
+make_json_push_parser(const d_config_t& cfg)
+{
+  return make_unique<JsonPushParserImpl>(nullptr, cfg);
+}
+
+JsonPushParserPtr
+make_json_push_parser(JsonHandler& handler, const d_config_t& cfg)
+{
+  return make_unique<JsonPushParserImpl>(&handler, cfg);
+}
+
+JsonReaderPtr
+make_json_reader(string_view sv)
+{
+  return make_unique<JsonReaderImpl>(sv);
+}
+
+JsonDocumentStreamPtr
+make_json_document_stream(istream& istrm, const d_config_t& cfg)
+{
+  return make_unique<JsonDocumentStreamImpl>(&istrm, string_view(), cfg);
+}
+
+JsonDocumentStreamPtr
+make_json_document_stream(string_view sv, const d_config_t& cfg)
+{
+  return make_unique<JsonDocumentStreamImpl>(nullptr, sv, cfg);
+}
+
+JsonDocumentStreamPtr
+make_json_document_stream_from_file(const string& path, const d_config_t& cfg)
+{
+  return make_unique<JsonDocumentStreamImpl>(make_unique<__file_view>(path),
+                                             cfg);
+}
+
+void
+parse_json_lines(string_view sv, const JsonRecordConsumer& consumer,
+                 const d_config_t& cfg)
+{
+  __parse_json_lines(sv, consumer, cfg);
+}
+
+void
+parse_json_lines_from_file(const string& path,
+                           const JsonRecordConsumer& consumer,
+                           const d_config_t& cfg)
+{
+  __file_view file(path);
+  __parse_json_lines(file.view(), consumer, cfg);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // serialization functions
 
 void
-write_json_data_text(ostream& ostrm, const JsonData* data,
-                     const s_config_t& cfg)
+write_json_data_text(__text_sink& out, const JsonData* data)
 {
   const JsonDataImpl* data_impl = static_cast<const JsonDataImpl*>(data);
   switch (data_impl->_native_type) {
   case JsonDataImpl::NativeType::NONE:
-    ostrm << "null";
+    out.put("null");
     break;
   case JsonDataImpl::NativeType::BOOL:
-    ostrm << (data_impl->_content.l ? "true" : "false");
+    out.put(data_impl->_content.l ? "true" : "false");
     break;
   case JsonDataImpl::NativeType::INT:
-    ostrm << static_cast<int64_t>(data_impl->_content.l);
+    out.put_int(static_cast<int64_t>(data_impl->_content.l));
     break;
   case JsonDataImpl::NativeType::FLOAT:
-    ostrm << defaultfloat << setprecision(10) << data_impl->_content.d;
+    out.put_double(data_impl->_content.d);
+    break;
+  case JsonDataImpl::NativeType::LAZY:
+    write_json_data_text(out, &data_impl->lazy_value());
     break;
   default:
     assert_msg(0, "corrupted JsonData native data type.");
@@ -1288,12 +6232,11 @@ write_json_data_text(ostream& ostrm, const JsonData* data,
 }
 
 void
-write_json_string_text(ostream& ostrm, const JsonString* string,
-                       const s_config_t& cfg)
+write_json_string_text(__text_sink& out, const JsonString* string)
 {
-  const JsonStringImpl* string_impl
-    = static_cast<const JsonStringImpl*>(string);
-  ostrm << '"' << __escape_string(string_impl->_content) << '"';
+  out.put('"');
+  out.put_escaped(string->to_string());
+  out.put('"');
 }
 
 struct ser_job_state_t {
@@ -1306,6 +6249,7 @@ struct ser_job_state_t {
 void
 write_json_text(ostream& ostrm, const JsonRecord* record, const s_config_t& cfg)
 {
+  __text_sink out(ostrm, cfg);
   std::stack<ser_job_state_t> job_stack;
   job_stack.push({ record });
   while (!job_stack.empty()) {
@@ -1315,21 +6259,23 @@ write_json_text(ostream& ostrm, const JsonRecord* record, const s_config_t& cfg)
     switch (active_job.record->type()) {
     case JsonRecord::Type::OBJECT:
       {
-        const JsonObject& obj = active_job.record->as_object();
+        const list<JsonObject::value_type>& obj
+          = static_cast<const JsonObjectImpl*>(active_job.record)->members();
         if (holds_alternative<monostate>(active_job.it)) {
           active_job.it = obj.begin();
-          ostrm << '{' << endl;
+          out.put('{');
+          out.line_break();
         }
         auto& it = get<JsonObject::const_iterator>(active_job.it);
         if (it == obj.end()) {
-          ostrm << endl;
-          __put_spaces(ostrm, curr_indent);
-          ostrm << '}';
+          out.line_break();
+          out.indent(curr_indent);
+          out.put('}');
           job_stack.pop();
         } else {
-          if (it != obj.begin()) { ostrm << ',' << endl; }
-          __put_spaces(ostrm, curr_indent + cfg.indentation_width);
-          ostrm << '"' << it->first << '"' << " : ";
+          if (it != obj.begin()) { out.put(','); out.line_break(); }
+          out.indent(curr_indent + cfg.indentation_width);
+          out.put_key(it->first);
           job_stack.push({ it->second.get() });
           ++ it;
         }
@@ -1337,37 +6283,173 @@ write_json_text(ostream& ostrm, const JsonRecord* record, const s_config_t& cfg)
       break;
     case JsonRecord::Type::ARRAY:
       {
-        const JsonArray& arr = active_job.record->as_array();
+        const vector<JsonRecordPtr>& arr
+          = static_cast<const JsonArrayImpl*>(active_job.record)->elements();
         if (holds_alternative<monostate>(active_job.it)) {
           active_job.it = arr.begin();
-          ostrm << '[' << endl;
+          out.put('[');
+          out.line_break();
         }
         auto& it = get<JsonArray::const_iterator>(active_job.it);
         if (it == arr.end()) {
-          ostrm << endl;
-          __put_spaces(ostrm, curr_indent);
-          ostrm << ']';
+          out.line_break();
+          out.indent(curr_indent);
+          out.put(']');
           job_stack.pop();
         } else {
-          if (it != arr.begin()) { ostrm << ',' << endl; }
-          __put_spaces(ostrm, curr_indent + cfg.indentation_width);
+          if (it != arr.begin()) { out.put(','); out.line_break(); }
+          out.indent(curr_indent + cfg.indentation_width);
           job_stack.push({ it->get() });
           ++ it;
         }
       }
       break;
     case JsonRecord::Type::DATA:
-      write_json_data_text(ostrm, &active_job.record->as_data(), cfg);
+      write_json_data_text(out, &active_job.record->as_data());
       job_stack.pop();
       break;
     case JsonRecord::Type::STRING:
-      write_json_string_text(ostrm, &active_job.record->as_string(), cfg);
+      write_json_string_text(out, &active_job.record->as_string());
       job_stack.pop();
       break;
     default:
       assert_msg(0, "corrupted json record type.");
     }
   }
+  out.flush();
+}
+
+/* The words of a tape are written in order, with the containers they are in
+ * kept on a stack, as whether their first element is still to come.
+ */
+void
+write_json_text(ostream& ostrm, const JsonTapeValue& value,
+                const s_config_t& cfg)
+{
+  __text_sink out(ostrm, cfg);
+  const JsonTapeImpl& tape = __tape_impl(value._tape);
+  size_t end = tape.skip(value._index);
+  vector<bool> first;  /* one per open array or object */
+  vector<bool> in_object;
+  for (size_t i = value._index; i < end; ) {
+    char tag = __tape_tag(tape.word(i));
+    int curr_indent = cfg.global_indentation
+                        + cfg.indentation_width * first.size();
+    if (tag == '}' || tag == ']') {
+      first.pop_back();
+      in_object.pop_back();
+      out.line_break();
+      out.indent(curr_indent - cfg.indentation_width);
+      out.put(tag);
+      ++ i;
+      continue;
+    }
+    if (!first.empty()) {
+      if (!first.back()) { out.put(','); out.line_break(); }
+      first.back() = false;
+      out.indent(curr_indent);
+      if (in_object.back()) {
+        out.put_key(tape.string_at(i));
+        tag = __tape_tag(tape.word(++ i));
+      }
+    }
+    switch (tag) {
+    case '{': case '[':
+      out.put(tag);
+      out.line_break();
+      first.push_back(true);
+      in_object.push_back(tag == '{');
+      break;
+    case '"':
+      out.put('"');
+      out.put_escaped(tape.string_at(i));
+      out.put('"');
+      break;
+    case 'l':
+      out.put_int(static_cast<int64_t>(tape.word(i + 1)));
+      break;
+    case 'd':
+      out.put_double(JsonTapeValue(&tape, i).as_double());
+      break;
+    case 'n':
+      out.put("null");
+      break;
+    case 't': case 'f':
+      out.put(tag == 't' ? "true" : "false");
+      break;
+    default:
+      assert_msg(0, "corrupted json tape.");
+    }
+    i = (tag == '{' || tag == '[') ? i + 1 : tape.skip(i);
+  }
+  out.flush();
+}
+
+void
+write_json_text(ostream& ostrm, const JsonValue& value, const s_config_t& cfg)
+{
+  __text_sink out(ostrm, cfg);
+  /* the arrays and objects being written, with the index of their next
+   * element */
+  vector<pair<const JsonValue*, size_t>> job_stack;
+  auto put = [&out, &job_stack](const JsonValue& v) {
+    switch (v.type()) {
+    case JsonRecord::Type::OBJECT:
+      out.put('{');
+      out.line_break();
+      job_stack.push_back({ &v, 0 });
+      break;
+    case JsonRecord::Type::ARRAY:
+      out.put('[');
+      out.line_break();
+      job_stack.push_back({ &v, 0 });
+      break;
+    case JsonRecord::Type::STRING:
+      out.put('"');
+      out.put_escaped(v.string_value());
+      out.put('"');
+      break;
+    default:
+      switch (static_cast<__value_kind>(v.kind())) {
+      case __value_kind::NONE:
+        out.put("null");
+        break;
+      case __value_kind::BOOL:
+        out.put(v._storage[0] ? "true" : "false");
+        break;
+      case __value_kind::INT:
+        out.put_int(__value_load<int64_t>(v._storage));
+        break;
+      default:
+        out.put_double(__value_load<double>(v._storage));
+      }
+    }
+  };
+  put(value);
+  while (!job_stack.empty()) {
+    const JsonValue& container = *job_stack.back().first;
+    size_t i = job_stack.back().second ++;
+    int curr_indent = cfg.global_indentation
+                        + cfg.indentation_width * (job_stack.size() - 1);
+    bool is_object = container.type() == JsonRecord::Type::OBJECT;
+    if (i == container.size()) {
+      out.line_break();
+      out.indent(curr_indent);
+      out.put(is_object ? '}' : ']');
+      job_stack.pop_back();
+      continue;
+    }
+    if (i) { out.put(','); out.line_break(); }
+    out.indent(curr_indent + cfg.indentation_width);
+    if (is_object) {
+      const JsonValue::member_type& member = container.as_object()[i];
+      out.put_key(member.first);
+      put(member.second);
+    } else {
+      put(container.as_array()[i]);
+    }
+  }
+  out.flush();
 }
 
 template <typename T>
@@ -1,3 +1,7 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -10,21 +14,79 @@ namespace J5Serdes {
 
 class JsonRecord;
 class JsonObject;
+class JsonKey;
 class JsonArray;
 class JsonData;
 class JsonString;
+class JsonPushParser;
+class JsonHandler;
+class JsonReader;
+class JsonDocumentStream;
+class JsonStringPool;
+class JsonDocument;
+class JsonTape;
+class JsonTapeValue;
+class JsonValue;
+class JsonReclaimer;
 
 typedef std::unique_ptr<JsonRecord> JsonRecordPtr;
 typedef std::unique_ptr<JsonObject> JsonObjectPtr;
 typedef std::unique_ptr<JsonArray>  JsonArrayPtr;
 typedef std::unique_ptr<JsonData>   JsonDataPtr;
 typedef std::unique_ptr<JsonString> JsonStringPtr;
+typedef std::unique_ptr<JsonPushParser> JsonPushParserPtr;
+typedef std::unique_ptr<JsonReader>     JsonReaderPtr;
+typedef std::unique_ptr<JsonDocumentStream> JsonDocumentStreamPtr;
+typedef std::unique_ptr<JsonStringPool>     JsonStringPoolPtr;
+typedef std::unique_ptr<JsonDocument>       JsonDocumentPtr;
+typedef std::unique_ptr<JsonTape>           JsonTapePtr;
+typedef std::unique_ptr<JsonReclaimer>      JsonReclaimerPtr;
+typedef std::function<void(JsonRecordPtr&&)> JsonRecordConsumer;
 
 struct d_config_t
 {
   bool strict_json;
+  /* Parses arrays, objects and scalars only when they are first accessed;
+   * the records keep the input alive, and report syntax errors in a value
+   * when it is accessed. As with other records, const accesses may be made
+   * from several threads at once: a value is then parsed by one of them.
+   */
+  bool lazy;
+  /* Parses the elements of a strict json document made of one large array
+   * on several threads; other documents are parsed on the calling thread.
+   */
+  bool parallel;
+  /* Builds only the values at these paths, along with the arrays and
+   * objects on the way to them; other values are skipped by bracket
+   * matching, without being decoded or validated (with strict_json, the
+   * whole document is still validated, but the skipped values are not
+   * decoded either). A path is a json pointer such as "/user/id", in which
+   * a `*' segment stands for any key or index; array elements off the paths
+   * are dropped, along with their indices.
+   * Applies to make_json_record() and parse_json_events(). Projecting an
+   * istream reads it whole into memory first, as strict_json does.
+   */
+  std::vector<std::string> paths;
+  /* worker threads of the parallel parsers; 0 for one per core */
+  unsigned threads;
+  /* whether parse_json_lines() passes on the records in input order */
+  bool ordered;
+  /* Makes the string values of a document that are equal share one copy,
+   * held by a pool: string_pool if set, possibly shared by several
+   * documents and threads, or else with intern_strings a pool of the
+   * document's own. Only values are pooled: object keys never are, as
+   * every member holds its key in a std::string of its own. See
+   * JsonStringPool for the values that are, and what pooling costs.
+   */
+  bool intern_strings;
+  std::shared_ptr<JsonStringPool> string_pool;
   d_config_t()
-    : strict_json(false)
+    : strict_json(false),
+      lazy(false),
+      parallel(false),
+      threads(0),
+      ordered(true),
+      intern_strings(false)
   {};
 };
 
@@ -33,16 +95,129 @@ struct s_config_t
   int  global_indentation;
   int  indentation_width;
   bool strict_json;
+  /* writes no line breaks nor indentation, and no spaces around colons */
+  bool compact;
   s_config_t()
     : global_indentation(0),
       indentation_width(2),
-      strict_json(false)
+      strict_json(false),
+      compact(false)
   {};
 };
 
 JsonRecordPtr
 make_json_record(std::istream&, const d_config_t& cfg = d_config_t());
 
+/* Parses a document held in a contiguous buffer; accepts the same input as
+ * the istream version, without the per-character stream overhead.
+ */
+JsonRecordPtr
+make_json_record(std::string_view, const d_config_t& cfg = d_config_t());
+JsonRecordPtr
+make_json_record(const char*, size_t, const d_config_t& cfg = d_config_t());
+
+/* Parses the file at the given path. Regular files are memory-mapped and
+ * parsed in place; other files (e.g. pipes) are read into memory first.
+ */
+JsonRecordPtr
+make_json_record_from_file(const std::string& path,
+                           const d_config_t& cfg = d_config_t());
+
+/* Creates a document whose records are allocated from arenas of its own, see
+ * JsonDocument. cfg.lazy is not supported.
+ */
+JsonDocumentPtr
+make_json_document();
+JsonDocumentPtr
+make_json_document(std::string_view, const d_config_t& cfg = d_config_t());
+JsonDocumentPtr
+make_json_document_from_file(const std::string& path,
+                             const d_config_t& cfg = d_config_t());
+
+/* Parses a document into a tape, a compact read-only form of it, see
+ * JsonTape. cfg.lazy is not supported; the document is parsed on the calling
+ * thread, and its strings are never pooled.
+ */
+JsonTapePtr
+make_json_tape(std::istream&, const d_config_t& cfg = d_config_t());
+JsonTapePtr
+make_json_tape(std::string_view, const d_config_t& cfg = d_config_t());
+JsonTapePtr
+make_json_tape_from_file(const std::string& path,
+                         const d_config_t& cfg = d_config_t());
+
+/* Parses a document into a JsonValue. cfg.lazy is not supported; the
+ * document is parsed on the calling thread, and its strings are never
+ * pooled. Duplicate keys are all kept, in order.
+ */
+JsonValue
+make_json_value(std::istream&, const d_config_t& cfg = d_config_t());
+JsonValue
+make_json_value(std::string_view, const d_config_t& cfg = d_config_t());
+JsonValue
+make_json_value_from_file(const std::string& path,
+                          const d_config_t& cfg = d_config_t());
+
+/* Parses a document into a sequence of JsonHandler events, without building
+ * any record; make_json_record() is the same parser with a handler building
+ * the records.
+ */
+void
+parse_json_events(std::istream&, JsonHandler&,
+                  const d_config_t& cfg = d_config_t());
+void
+parse_json_events(std::string_view, JsonHandler&,
+                  const d_config_t& cfg = d_config_t());
+
+/* Creates a parser for a document delivered in consecutive chunks, e.g. as
+ * they are received from the network. A chunk may end anywhere, including in
+ * the middle of a string, an escape sequence, a number or a comment. With a
+ * handler, the events are sent as soon as each token is complete, and
+ * finish() returns nullptr; this holds with strict_json too. A lazy document
+ * keeps its whole input, so without a handler and with lazy set, the input
+ * is only parsed by finish().
+ */
+JsonPushParserPtr
+make_json_push_parser(const d_config_t& cfg = d_config_t());
+JsonPushParserPtr
+make_json_push_parser(JsonHandler&, const d_config_t& cfg = d_config_t());
+
+/* Creates a forward-only cursor over a document in memory, which must
+ * outlive the reader. No record is built.
+ */
+JsonReaderPtr
+make_json_reader(std::string_view);
+
+/* Creates a reader for a sequence of documents, e.g. newline delimited json
+ * (NDJSON, JSON Lines) or documents simply written one after another. With
+ * strict_json, the input must hold one document per line. The istream or
+ * the buffer must outlive the stream; lazy documents are not supported.
+ */
+JsonDocumentStreamPtr
+make_json_document_stream(std::istream&,
+                          const d_config_t& cfg = d_config_t());
+JsonDocumentStreamPtr
+make_json_document_stream(std::string_view,
+                          const d_config_t& cfg = d_config_t());
+JsonDocumentStreamPtr
+make_json_document_stream_from_file(const std::string& path,
+                                    const d_config_t& cfg = d_config_t());
+
+/* Parses newline delimited documents on several threads. The input is split
+ * into chunks at line breaks, and each chunk is parsed by one of the workers.
+ * The consumer is called on the calling thread only, with the records of a
+ * chunk in order; the chunks are passed on in input order, or as soon as
+ * they are parsed when cfg.ordered is cleared. A document must not span
+ * several lines. The first error of a worker is rethrown once the workers
+ * have stopped.
+ */
+void
+parse_json_lines(std::string_view, const JsonRecordConsumer&,
+                 const d_config_t& cfg = d_config_t());
+void
+parse_json_lines_from_file(const std::string& path, const JsonRecordConsumer&,
+                           const d_config_t& cfg = d_config_t());
+
 JsonObjectPtr
 make_json_object();
 JsonObjectPtr
@@ -68,6 +243,23 @@ make_json_data(T value);
 
 JsonStringPtr
 make_json_string(std::string_view value);
+/* takes the buffer of value */
+JsonStringPtr
+make_json_string(std::string&& value);
+JsonStringPtr
+make_json_string(const char* value);
+
+/* Creates a pool for d_config_t::string_pool, interning the string values
+ * of up to max_length bytes.
+ */
+JsonStringPoolPtr
+make_json_string_pool(size_t max_length = 64);
+
+/* Starts a thread deleting the records handed over to it, see
+ * JsonReclaimer.
+ */
+JsonReclaimerPtr
+make_json_reclaimer();
 
 void
 write_json_text(std::ostream&, const JsonRecord*,
@@ -80,6 +272,16 @@ template <typename T>
 void write_json_text(std::ostream&, const std::unique_ptr<T>&,
                      const s_config_t& cfg = s_config_t());
 
+/* Writes the value of a tape as write_json_text() writes the same value made
+ * of records.
+ */
+void
+write_json_text(std::ostream&, const JsonTapeValue&,
+                const s_config_t& cfg = s_config_t());
+void
+write_json_text(std::ostream&, const JsonValue&,
+                const s_config_t& cfg = s_config_t());
+
 
 class JsonRecord {
 public:
@@ -87,6 +289,12 @@ public:
     { OBJECT = 0, ARRAY = 1, DATA = 2, STRING = 3 };
   virtual ~JsonRecord() = default;
   virtual Type type() const = 0;
+  /* Objects and arrays share their members with their clones, until either
+   * side modifies them or hands out a reference, pointer or iterator to a
+   * member, const ones included: that side first copies the members for
+   * itself. A record which handed out a member shares nothing: its clones
+   * copy the members at once, and what it handed out keeps following it.
+   */
   virtual JsonRecordPtr clone() const = 0;
   virtual JsonArray& as_array();
   virtual JsonObject& as_object();
@@ -98,6 +306,23 @@ public:
   virtual const JsonString& as_string() const;
 };
 
+/* A key made once and looked up repeatedly, e.g. in every object of a large
+ * array: its hash is computed when it is made, and objects large enough to
+ * be indexed are probed with it directly. Smaller objects are scanned, and
+ * compare its content.
+ */
+class JsonKey {
+public:
+  explicit JsonKey(std::string_view key);
+
+  const std::string& str() const { return _key; };
+  size_t             hash() const { return _hash; };
+
+private:
+  std::string _key;
+  size_t      _hash;
+};
+
 class JsonObject : public JsonRecord {
 public:
   virtual ~JsonObject() = default;
@@ -109,20 +334,36 @@ public:
   typedef std::list<value_type>::iterator       iterator;
   typedef std::list<value_type>::const_iterator const_iterator;
 
+  /* Keys are looked up as views, with a single probe and no copy; keys of
+   * std::string and literals convert implicitly. A key is copied only into
+   * a new member, and the record passed is left alone if the key is found.
+   */
   virtual std::pair<iterator, bool> insert(value_type&&) = 0;
   virtual std::pair<iterator, bool> insert(std::string_view,
                                            JsonRecordPtr&&) = 0;
   virtual std::pair<iterator, bool> insert(std::string_view,
                                            const JsonRecordPtr&) = 0;
-
-  virtual iterator                  find(const std::string& key) = 0;
-  virtual const_iterator            find(const std::string& key) const = 0;
-
-  virtual JsonRecordPtr&            at(const std::string& key) = 0;
-  virtual const JsonRecord*         at(const std::string& key) const = 0;
+  /* Like insert(), with the key moved into the new member, and returning
+   * the member found otherwise. The type overload makes an empty object,
+   * array or string, or a null, only if the key is not found.
+   */
+  virtual std::pair<iterator, bool> try_emplace(std::string&& key,
+                                                JsonRecordPtr&&) = 0;
+  virtual std::pair<iterator, bool> try_emplace(std::string&& key,
+                                                JsonRecord::Type) = 0;
+
+  virtual iterator                  find(std::string_view key) = 0;
+  virtual const_iterator            find(std::string_view key) const = 0;
+  virtual iterator                  find(const JsonKey& key) = 0;
+  virtual const_iterator            find(const JsonKey& key) const = 0;
+
+  virtual JsonRecordPtr&            at(std::string_view key) = 0;
+  virtual const JsonRecord*         at(std::string_view key) const = 0;
+  virtual JsonRecordPtr&            at(const JsonKey& key) = 0;
+  virtual const JsonRecord*         at(const JsonKey& key) const = 0;
 
   virtual iterator                  erase(const_iterator) = 0;
-  virtual size_t                    erase(const std::string& key) = 0;
+  virtual size_t                    erase(std::string_view key) = 0;
 
   virtual iterator                  begin() = 0;
   virtual const_iterator            begin() const = 0;
@@ -131,11 +372,12 @@ public:
 
   virtual void                      clear() = 0;
 
-  virtual size_t                    count(const std::string& key) const = 0;
+  virtual size_t                    count(std::string_view key) const = 0;
+  virtual size_t                    count(const JsonKey& key) const = 0;
   virtual bool                      empty() const = 0;
   virtual size_t                    size() const = 0;
 
-  virtual JsonRecordPtr&            operator[](const std::string& key) = 0;
+  virtual JsonRecordPtr&            operator[](std::string_view key) = 0;
 };
 
 class JsonArray : public JsonRecord {
@@ -150,6 +392,8 @@ public:
 
   virtual void              push_back(JsonRecordPtr&&) = 0;
   virtual void              push_back(const JsonRecordPtr&) = 0;
+  /* appends an empty object, array or string, or a null */
+  virtual JsonRecordPtr&    emplace_back(JsonRecord::Type) = 0;
 
   virtual iterator          begin() = 0;
   virtual const_iterator    begin() const = 0;
@@ -194,4 +438,315 @@ public:
   virtual const std::string& to_string() const = 0;
 };
 
+class JsonPushParser {
+public:
+  virtual ~JsonPushParser() = default;
+
+  /* parses the complete tokens of the chunk, and keeps the incomplete one
+   * at its end until the next chunk arrives */
+  virtual void          feed(const char*, size_t) = 0;
+  void                  feed(std::string_view sv)
+                          { feed(sv.data(), sv.size()); };
+
+  /* marks the end of the input and returns the document */
+  virtual JsonRecordPtr finish() = 0;
+};
+
+class JsonDocumentStream {
+public:
+  virtual ~JsonDocumentStream() = default;
+
+  /* returns the next document, or nullptr at the end of the input */
+  virtual JsonRecordPtr next() = 0;
+};
+
+/* Owns the records of a document, parsed or made by its make_*() functions,
+ * which are allocated from arenas along with the bodies of its arrays and
+ * objects: the document destroys them from its root, and frees their memory
+ * all at once. The members of objects, their keys, the element vectors of
+ * arrays and long strings are still allocated one by one from the heap, as
+ * std::list, std::string and std::vector in the types of the API. A record
+ * of the document may only be placed in another record of the same
+ * document, and must not outlive it; its clones are independent records.
+ * Records made elsewhere may be placed in the document freely, and take no
+ * more memory for the existence of documents. The make_*() functions are
+ * not thread safe.
+ */
+class JsonDocument {
+public:
+  virtual ~JsonDocument() = default;
+
+  virtual JsonRecordPtr&       root() = 0;
+  virtual const JsonRecord*    root() const = 0;
+
+  virtual JsonObjectPtr        make_object() = 0;
+  virtual JsonArrayPtr         make_array() = 0;
+  virtual JsonDataPtr          make_data() = 0;
+  template<typename T>
+  JsonDataPtr                  make_data(T value);
+  virtual JsonStringPtr        make_string(std::string_view value) = 0;
+};
+
+/* A handle on a value of a JsonTape, valid as long as the tape. Handles are
+ * copied by value, and read the tape in place: the scalar accessors convert
+ * as those of JsonData and JsonString do, and keys are looked up by a linear
+ * scan of the members, the first of duplicate keys being found.
+ */
+class JsonTapeValue {
+public:
+  class const_iterator;
+
+  JsonRecord::Type   type() const;
+
+  bool               is_null() const;
+  bool               as_bool() const;
+  double             as_double() const;
+  long long          as_int() const;
+  unsigned long long as_unsigned() const;
+  /* the content of a string, valid as long as the tape */
+  std::string_view   string_value() const;
+  std::string        to_string() const;
+
+  /* the elements of an array, or the members of an object */
+  const_iterator     begin() const;
+  const_iterator     end() const;
+
+  const_iterator     find(std::string_view key) const;
+  JsonTapeValue      at(std::string_view key) const;
+  JsonTapeValue      at(size_t) const;
+  JsonTapeValue      operator[](size_t i) const { return at(i); };
+
+  size_t             count(std::string_view key) const;
+  bool               empty() const;
+  size_t             size() const;
+
+private:
+  friend class JsonTapeImpl;
+  friend void write_json_text(std::ostream&, const JsonTapeValue&,
+                              const s_config_t&);
+
+  JsonTapeValue(const JsonTape* tape, size_t index)
+    : _tape(tape), _index(index) {};
+
+  const JsonTape* _tape;
+  size_t          _index;  /* of the first word of the value */
+};
+
+class JsonTapeValue::const_iterator {
+public:
+  JsonTapeValue    operator*() const { return JsonTapeValue(_tape, value()); };
+  /* the key of an object member */
+  std::string_view key() const;
+
+  const_iterator&  operator++();
+  bool             operator==(const const_iterator& other) const
+                     { return _index == other._index; };
+  bool             operator!=(const const_iterator& other) const
+                     { return _index != other._index; };
+
+private:
+  friend class JsonTapeValue;
+
+  const_iterator(const JsonTape* tape, size_t index, bool in_object)
+    : _tape(tape), _index(index), _in_object(in_object) {};
+  size_t value() const { return _in_object ? _index + 1 : _index; };
+
+  const JsonTape* _tape;
+  size_t          _index;  /* of the key of a member, or of an element */
+  bool            _in_object;
+};
+
+/* A document parsed into one contiguous array of 64-bit words, its strings
+ * and keys being decoded into one buffer beside it: scalars take one or two
+ * words, and nothing is allocated per value. An array or an object spans the
+ * words of its elements, between a word at its start holding the index of
+ * its end, and a word at its end holding its size. Tapes are read-only, and
+ * read through JsonTapeValue handles.
+ */
+class JsonTape {
+public:
+  virtual ~JsonTape() = default;
+
+  virtual JsonTapeValue root() const = 0;
+
+  /* bytes held by the words and the string buffer */
+  virtual size_t        memory_usage() const = 0;
+};
+
+/* A value of a document held in 16 bytes, with no virtual functions:
+ * numbers, booleans, null and strings of up to 15 bytes are stored inline,
+ * and longer strings, arrays and objects out of line, owned by the value.
+ * The elements of an array are stored contiguously, and so are the members
+ * of an object, in insertion order; keys are looked up by a linear scan, the
+ * first of duplicate keys being found. Values are copied deeply and moved
+ * in O(1); the scalar accessors convert as those of JsonData and JsonString
+ * do.
+ */
+class JsonValue {
+public:
+  typedef std::vector<JsonValue>            array_type;
+  typedef std::pair<std::string, JsonValue> member_type;
+  typedef std::vector<member_type>          object_type;
+
+  /* null */
+  JsonValue() noexcept : _storage(), _tag(0) {};
+  /* an empty object, array or string, or null for DATA */
+  explicit JsonValue(JsonRecord::Type);
+  JsonValue(bool);
+  JsonValue(double);
+  JsonValue(int64_t);
+  JsonValue(uint64_t);
+  JsonValue(int);
+  JsonValue(unsigned);
+  JsonValue(std::string_view);
+  JsonValue(const char* value) : JsonValue(std::string_view(value)) {};
+  JsonValue(array_type&&);
+  JsonValue(object_type&&);
+  JsonValue(const JsonValue&);
+  JsonValue(JsonValue&&) noexcept;
+  JsonValue& operator=(const JsonValue&);
+  JsonValue& operator=(JsonValue&&) noexcept;
+  ~JsonValue();
+
+  JsonRecord::Type         type() const;
+
+  bool                     is_null() const;
+  bool                     as_bool() const;
+  double                   as_double() const;
+  long long                as_int() const;
+  unsigned long long       as_unsigned() const;
+  /* the content of a string, valid until the value is modified */
+  std::string_view         string_value() const;
+  std::string              to_string() const;
+
+  array_type&              as_array();
+  const array_type&        as_array() const;
+  object_type&             as_object();
+  const object_type&       as_object() const;
+
+  object_type::iterator       find(std::string_view key);
+  object_type::const_iterator find(std::string_view key) const;
+  JsonValue&               at(std::string_view key);
+  const JsonValue&         at(std::string_view key) const;
+  /* inserts a null value at the end if key is missing */
+  JsonValue&               operator[](std::string_view key);
+  size_t                   erase(std::string_view key);
+  size_t                   count(std::string_view key) const;
+
+  JsonValue&               at(size_t);
+  const JsonValue&         at(size_t) const;
+  JsonValue&               operator[](size_t i) { return at(i); };
+  const JsonValue&         operator[](size_t i) const { return at(i); };
+
+  /* of an array or an object */
+  bool                     empty() const;
+  size_t                   size() const;
+
+private:
+  friend void write_json_text(std::ostream&, const JsonValue&,
+                              const s_config_t&);
+
+  uint8_t kind() const;
+  void    release() noexcept;
+
+  alignas(8) char _storage[15];  /* a scalar, an inline string or a pointer */
+  uint8_t         _tag;          /* the kind, and the size of an inline string */
+};
+
+/* Holds one copy of each distinct string value of the documents parsed with
+ * it; object keys are left out. Values short enough for the inline buffer
+ * of std::string cost no allocation and are not pooled either. The records
+ * keep their strings alive, so the pool may be cleared or destroyed at any
+ * time; it only stops the later records from sharing the strings of the
+ * earlier ones.
+ * A pooled value is a record of a class of its own, so the other string
+ * records are no larger for it. This pool, which may be shared across
+ * threads, takes a lock for each value; the pool of a single document made
+ * with d_config_t::intern_strings takes none, unless the document is parsed
+ * in parallel, its slices then sharing one locked pool. Pooling pays off
+ * for values repeated throughout the documents, such as categories or
+ * enumerations, and about doubles the parse time of values that are mostly
+ * distinct.
+ */
+class JsonStringPool {
+public:
+  virtual ~JsonStringPool() = default;
+
+  virtual size_t size() const = 0;
+  virtual void   clear() = 0;
+};
+
+/* Deletes records on a thread of its own, running at a low priority where
+ * the system allows it, so that dropping a large document costs its owner
+ * no more than a hand-over. The records retired while the thread is busy
+ * are deleted together, in one batch. Records of a JsonDocument must not be
+ * retired. Destroying the reclaimer deletes the records still retired, and
+ * stops the thread. All functions are thread safe.
+ */
+class JsonReclaimer {
+public:
+  virtual ~JsonReclaimer() = default;
+
+  virtual void   retire(JsonRecordPtr&&) = 0;
+  /* waits until the records retired so far are deleted */
+  virtual void   drain() = 0;
+  /* the number of records retired and not deleted yet */
+  virtual size_t pending() const = 0;
+};
+
+/* Receives the parser events of parse_json_events() and push parsers. The
+ * string_view arguments are only valid during the call. All events are
+ * ignored by default; integers are forwarded to on_number() unless
+ * on_integer() is overridden.
+ */
+class JsonHandler {
+public:
+  virtual ~JsonHandler() = default;
+
+  virtual void on_object_begin() {};
+  virtual void on_object_end() {};
+  virtual void on_array_begin() {};
+  virtual void on_array_end() {};
+  virtual void on_key(std::string_view) {};
+
+  virtual void on_string(std::string_view) {};
+  virtual void on_number(double) {};
+  virtual void on_integer(long long value)
+                 { on_number(static_cast<double>(value)); };
+  virtual void on_bool(bool) {};
+  virtual void on_null() {};
+};
+
+/* Pulls the tokens of a document one at a time. The views returned by key()
+ * and string_value() are only valid until the next call to next() or
+ * skip_value().
+ */
+class JsonReader {
+public:
+  enum class Token : unsigned int {
+    END = 0, OBJECT_BEGIN, OBJECT_END, ARRAY_BEGIN, ARRAY_END, KEY,
+    STRING, NUMBER, BOOL, NULL_VALUE
+  };
+  virtual ~JsonReader() = default;
+
+  /* advances to the next token; END once the document is exhausted */
+  virtual Token              next() = 0;
+  virtual Token              token() const = 0;
+
+  /* Skips the value the current token belongs to: after a KEY, its value,
+   * so that next() returns what follows it; after an OBJECT_BEGIN or an
+   * ARRAY_BEGIN, everything up to the matching end, which becomes the
+   * current token. Nested values are skipped by bracket matching, with no
+   * decoding or validation of their content.
+   */
+  virtual void               skip_value() = 0;
+
+  virtual std::string_view   key() const = 0;
+  virtual std::string_view   string_value() const = 0;
+  virtual bool               is_integer() const = 0;
+  virtual double             number_value() const = 0;
+  virtual long long          integer_value() const = 0;
+  virtual bool               bool_value() const = 0;
+};
+
 }
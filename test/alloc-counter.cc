@@ -0,0 +1,62 @@
+#include "alloc-counter.h"
+#include <cstdlib>
+#include <new>
+
+/* The replacements live in their own translation unit so that the compiler
+ * never sees a builtin new paired with the free() of a replaced delete, and
+ * form a complete set so that every new/delete pair goes through malloc().
+ */
+
+std::atomic<size_t> __allocations(0);
+
+static void*
+__counted_alloc(size_t size, size_t align = 0) noexcept
+{
+  __allocations.fetch_add(1, std::memory_order_relaxed);
+  if (!align) { return malloc(size ? size : 1); }
+  size = (size + align - 1) / align * align;
+  return aligned_alloc(align, size ? size : align);
+}
+
+static void*
+__counted_alloc_or_throw(size_t size, size_t align = 0)
+{
+  void* p = __counted_alloc(size, align);
+  if (!p) { throw std::bad_alloc(); }
+  return p;
+}
+
+void* operator new(size_t size)
+{ return __counted_alloc_or_throw(size); }
+void* operator new[](size_t size)
+{ return __counted_alloc_or_throw(size); }
+void* operator new(size_t size, std::align_val_t al)
+{ return __counted_alloc_or_throw(size, size_t(al)); }
+void* operator new[](size_t size, std::align_val_t al)
+{ return __counted_alloc_or_throw(size, size_t(al)); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{ return __counted_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{ return __counted_alloc(size); }
+void* operator new(size_t size, std::align_val_t al,
+                   const std::nothrow_t&) noexcept
+{ return __counted_alloc(size, size_t(al)); }
+void* operator new[](size_t size, std::align_val_t al,
+                     const std::nothrow_t&) noexcept
+{ return __counted_alloc(size, size_t(al)); }
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept { free(p); }
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/* Counts the allocations of the whole test binary, library included, made
+ * through any form of the global operator new; the records themselves are
+ * allocated with malloc, and are not counted.
+ */
+extern std::atomic<size_t> __allocations;
@@ -254,9 +254,9 @@ TestManagerImpl::run(const TestPlanConfig& cfg)
       ++ get<1>(suite_info.back());
     }
   }
-  suite_info.erase(remove_if(suite_info.begin(), suite_info.end(),
-                             [](auto& x) { return get<1>(x) == 0; }),
-                   suite_info.end());
+  /* list::remove_if() unlinks the nodes in place, which keeps the suite
+   * pointers held by filtered_tests valid. */
+  suite_info.remove_if([](auto& x) { return get<1>(x) == 0; });
 
   if (cfg.list_only) {
     string_view last_suite;
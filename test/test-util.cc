@@ -0,0 +1,69 @@
+#include "test-util.h"
+#include <sstream>
+
+using namespace J5Serdes;
+using namespace std;
+
+const char* const __sample_document =
+  R"({ "id": 12, "name": "a \"quoted\" name longer than fifteen bytes",
+       "ratio": 0.25, "tags": [ "x", [], {}, [ 1, [ 2 ] ] ], "ok": true,
+       "no": false, "parent": null, "big": -9007199254740993,
+       "items": [ { "sku": "x1", "price": 2.5 }, { "sku": "x2" } ] })";
+
+template <typename T>
+static string
+__serialize_any(const T& value)
+{
+  stringstream ss;
+  write_json_text(ss, value);
+  return ss.str();
+}
+
+string
+__serialize(const JsonRecord* record)
+{
+  return __serialize_any(record);
+}
+
+string
+__serialize(const JsonRecordPtr& record)
+{
+  return __serialize_any(record);
+}
+
+string
+__serialize(const JsonTapeValue& value)
+{
+  return __serialize_any(value);
+}
+
+string
+__serialize(const JsonValue& value)
+{
+  return __serialize_any(value);
+}
+
+d_config_t
+__strict_config()
+{
+  d_config_t cfg;
+  cfg.strict_json = true;
+  return cfg;
+}
+
+d_config_t
+__lazy_config()
+{
+  d_config_t cfg;
+  cfg.lazy = true;
+  return cfg;
+}
+
+d_config_t
+__projection_config(const vector<string>& paths, bool strict)
+{
+  d_config_t cfg;
+  cfg.paths = paths;
+  cfg.strict_json = strict;
+  return cfg;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "j5serdes.h"
+#include <string>
+#include <vector>
+
+/* Fixtures shared by the test files. */
+
+/* a document with every kind of value, strings longer than the inline
+ * buffer of std::string, and an integer beyond the precision of a double */
+extern const char* const __sample_document;
+
+/* the compact text of a record or value, to compare documents with */
+std::string __serialize(const J5Serdes::JsonRecord*);
+std::string __serialize(const J5Serdes::JsonRecordPtr&);
+std::string __serialize(const J5Serdes::JsonTapeValue&);
+std::string __serialize(const J5Serdes::JsonValue&);
+
+J5Serdes::d_config_t __strict_config();
+J5Serdes::d_config_t __lazy_config();
+J5Serdes::d_config_t __projection_config(const std::vector<std::string>& paths,
+                                         bool strict = false);
@@ -0,0 +1,604 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace J5Serdes;
+using namespace std;
+
+/* Benchmarks are disabled by default; run them with
+ *   ./test --also_run_disabled_tests --filter 'Benchmark.*'
+ */
+
+static string
+__make_mixed_document(size_t approx_size)
+{
+  string ret = "[\n";
+  for (size_t i=0; ret.size() < approx_size; ++i) {
+    if (i) { ret += ",\n"; }
+    ret += "  { \"id\": " + to_string(i) +
+           ", \"name\": \"item number " + to_string(i) + "\"" +
+           ", \"price\": " + to_string(i * 0.25) +
+           ", \"tags\": [ \"alpha\", \"beta\", \"gamma\" ]" +
+           ", \"active\": " + (i & 1 ? "true" : "false") +
+           ", \"parent\": null }";
+  }
+  ret += "\n]\n";
+  return ret;
+}
+
+static string
+__make_numeric_document(size_t approx_size)
+{
+  string ret = "{ \"type\": \"LineString\", \"coordinates\": [\n";
+  for (size_t i=0; ret.size() < approx_size; ++i) {
+    if (i) { ret += ",\n"; }
+    ret += "  [ " + to_string(-122.4194155 + i * 1e-6) + ", "
+           + to_string(37.7749295 - i * 1e-6) + ", " + to_string(i % 4096)
+           + " ]";
+  }
+  ret += "\n] }\n";
+  return ret;
+}
+
+/* many short tokens per byte: small objects with one-letter keys */
+static string
+__make_token_dense_document(size_t approx_size)
+{
+  string ret = "[";
+  for (size_t i=0; ret.size() < approx_size; ++i) {
+    if (i) { ret += ","; }
+    ret += "{\"a\":" + to_string(i % 10) + ",\"b\":[" + to_string(i % 7)
+           + ",true],\"c\":{\"d\":null}}";
+  }
+  ret += "]";
+  return ret;
+}
+
+/* one small object per line */
+static string
+__make_ndjson_document(size_t approx_size)
+{
+  string ret;
+  for (size_t i=0; ret.size() < approx_size; ++i) {
+    ret += "{\"id\":" + to_string(i) + ",\"level\":\"info\""
+           + ",\"msg\":\"request " + to_string(i) + " served\""
+           + ",\"ms\":" + to_string(i % 100 * 0.5) + "}\n";
+  }
+  return ret;
+}
+
+template <typename F>
+static double
+__measure_mbps(size_t bytes, int repeat, F&& func)
+{
+  auto begin = chrono::steady_clock::now();
+  for (int i=0; i<repeat; ++i) { func(); }
+  auto end = chrono::steady_clock::now();
+  double sec = chrono::duration<double>(end - begin).count();
+  return static_cast<double>(bytes) * repeat / sec / (1024. * 1024.);
+}
+
+TEST(Benchmark, DISABLED_buffer_vs_istream)
+{
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  double istream_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    istringstream istrm(doc);
+    auto record = make_json_record(istrm);
+  });
+  double buffer_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "istream path  : " << istream_mbps << " MB/s" << endl
+       << "buffer path   : " << buffer_mbps << " MB/s" << endl;
+  ASSERT_TRUE(istream_mbps > 0. && buffer_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_strict_json)
+{
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  d_config_t strict_cfg;
+  strict_cfg.strict_json = true;
+  double json5_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  double strict_mbps = __measure_mbps(doc.size(), repeat,
+                                      [&doc, &strict_cfg]() {
+    auto record = make_json_record(string_view(doc), strict_cfg);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "json5 parser  : " << json5_mbps << " MB/s" << endl
+       << "strict parser : " << strict_mbps << " MB/s" << endl;
+  ASSERT_TRUE(json5_mbps > 0. && strict_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_numeric_document)
+{
+  const string doc = __make_numeric_document(8 << 20);
+  const int repeat = 5;
+  double buffer_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "buffer path   : " << buffer_mbps << " MB/s" << endl;
+  ASSERT_TRUE(buffer_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_token_dense)
+{
+  const string doc = __make_token_dense_document(8 << 20);
+  const int repeat = 5;
+  double istream_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    istringstream istrm(doc);
+    auto record = make_json_record(istrm);
+  });
+  double buffer_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "istream path  : " << istream_mbps << " MB/s" << endl
+       << "buffer path   : " << buffer_mbps << " MB/s" << endl;
+  ASSERT_TRUE(istream_mbps > 0. && buffer_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_events_vs_records)
+{
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  struct count_t : public JsonHandler {
+    size_t n = 0;
+    void on_integer(long long) { ++ n; }
+  } handler;
+  double records_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  double events_mbps = __measure_mbps(doc.size(), repeat,
+                                      [&doc, &handler]() {
+    parse_json_events(doc, handler);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "records       : " << records_mbps << " MB/s" << endl
+       << "events        : " << events_mbps << " MB/s" << endl;
+  ASSERT_TRUE(records_mbps > 0. && events_mbps > 0. && handler.n > 0);
+}
+
+TEST(Benchmark, DISABLED_reader_skip)
+{
+  /* reads one field of each element and skips the rest */
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  long long sum = 0;
+  double reader_mbps = __measure_mbps(doc.size(), repeat, [&doc, &sum]() {
+    JsonReaderPtr reader = make_json_reader(doc);
+    reader->next();
+    while (reader->next() == JsonReader::Token::OBJECT_BEGIN) {
+      while (reader->next() == JsonReader::Token::KEY) {
+        if (reader->key() == "id") {
+          reader->next();
+          sum += reader->integer_value();
+        } else {
+          reader->skip_value();
+        }
+      }
+    }
+  });
+  double skip_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    JsonReaderPtr reader = make_json_reader(doc);
+    reader->next();
+    reader->skip_value();
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "selective read: " << reader_mbps << " MB/s" << endl
+       << "skip document : " << skip_mbps << " MB/s" << endl;
+  ASSERT_TRUE(reader_mbps > 0. && skip_mbps > 0. && sum > 0);
+}
+
+TEST(Benchmark, DISABLED_lazy_access)
+{
+  /* reads the id of every 20th element */
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  long long sum = 0;
+  auto touch = [&sum](const JsonRecordPtr& record) {
+    const JsonArray& arr = record->as_array();
+    for (size_t i=0; i<arr.size(); i+=20) {
+      sum += arr[i]->as_object().at("id")->as_data().as_int();
+    }
+  };
+  d_config_t lazy_cfg;
+  lazy_cfg.lazy = true;
+  double eager_mbps = __measure_mbps(doc.size(), repeat, [&doc, &touch]() {
+    touch(make_json_record(string_view(doc)));
+  });
+  double lazy_mbps = __measure_mbps(doc.size(), repeat,
+                                    [&doc, &touch, &lazy_cfg]() {
+    touch(make_json_record(string_view(doc), lazy_cfg));
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "eager records : " << eager_mbps << " MB/s" << endl
+       << "lazy records  : " << lazy_mbps << " MB/s" << endl;
+  ASSERT_TRUE(eager_mbps > 0. && lazy_mbps > 0. && sum > 0);
+}
+
+TEST(Benchmark, DISABLED_ndjson)
+{
+  const string doc = __make_ndjson_document(8 << 20);
+  const int repeat = 5;
+  size_t count = 0;
+  double split_mbps = __measure_mbps(doc.size(), repeat, [&doc, &count]() {
+    /* a record per line, each parsed on its own */
+    istringstream istrm(doc);
+    for (string line; getline(istrm, line); ) {
+      count += make_json_record(line) != nullptr;
+    }
+  });
+  auto read_all = [&count](JsonDocumentStream& stream) {
+    while (stream.next()) { ++count; }
+  };
+  double stream_mbps = __measure_mbps(doc.size(), repeat,
+                                      [&doc, &read_all]() {
+    read_all(*make_json_document_stream(string_view(doc)));
+  });
+  double istream_mbps = __measure_mbps(doc.size(), repeat,
+                                       [&doc, &read_all]() {
+    istringstream istrm(doc);
+    read_all(*make_json_document_stream(istrm));
+  });
+  d_config_t strict_cfg;
+  strict_cfg.strict_json = true;
+  double strict_mbps = __measure_mbps(doc.size(), repeat,
+                                      [&doc, &read_all, &strict_cfg]() {
+    read_all(*make_json_document_stream(string_view(doc), strict_cfg));
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "line by line  : " << split_mbps << " MB/s" << endl
+       << "stream        : " << stream_mbps << " MB/s" << endl
+       << "istream       : " << istream_mbps << " MB/s" << endl
+       << "strict stream : " << strict_mbps << " MB/s" << endl;
+  ASSERT_TRUE(split_mbps > 0. && stream_mbps > 0. && istream_mbps > 0.
+              && strict_mbps > 0. && count > 0);
+}
+
+TEST(Benchmark, DISABLED_parallel_lines)
+{
+  const string doc = __make_ndjson_document(32 << 20);
+  const int repeat = 3;
+  size_t count = 0;
+  auto consume = [&count](JsonRecordPtr&&) { ++count; };
+  double stream_mbps = __measure_mbps(doc.size(), repeat, [&doc, &count]() {
+    JsonDocumentStreamPtr stream = make_json_document_stream(doc);
+    while (stream->next()) { ++count; }
+  });
+  d_config_t cfg;
+  double ordered_mbps = __measure_mbps(doc.size(), repeat,
+                                       [&doc, &consume, &cfg]() {
+    parse_json_lines(doc, consume, cfg);
+  });
+  cfg.ordered = false;
+  double unordered_mbps = __measure_mbps(doc.size(), repeat,
+                                         [&doc, &consume, &cfg]() {
+    parse_json_lines(doc, consume, cfg);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "threads       : " << thread::hardware_concurrency() << endl
+       << "one thread    : " << stream_mbps << " MB/s" << endl
+       << "ordered       : " << ordered_mbps << " MB/s" << endl
+       << "unordered     : " << unordered_mbps << " MB/s" << endl;
+  ASSERT_TRUE(stream_mbps > 0. && ordered_mbps > 0. && unordered_mbps > 0.
+              && count > 0);
+}
+
+TEST(Benchmark, DISABLED_parallel_array)
+{
+  const string doc = __make_mixed_document(64 << 20);
+  const int repeat = 3;
+  d_config_t cfg;
+  cfg.strict_json = true;
+  double serial_mbps = __measure_mbps(doc.size(), repeat, [&doc, &cfg]() {
+    auto record = make_json_record(string_view(doc), cfg);
+  });
+  cfg.parallel = true;
+  double parallel_mbps = __measure_mbps(doc.size(), repeat, [&doc, &cfg]() {
+    auto record = make_json_record(string_view(doc), cfg);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "threads       : " << thread::hardware_concurrency() << endl
+       << "one thread    : " << serial_mbps << " MB/s" << endl
+       << "parallel      : " << parallel_mbps << " MB/s" << endl;
+  ASSERT_TRUE(serial_mbps > 0. && parallel_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_projection)
+{
+  /* keeps the id of every element */
+  const string doc = __make_mixed_document(8 << 20);
+  const int repeat = 5;
+  d_config_t cfg;
+  double full_mbps = __measure_mbps(doc.size(), repeat, [&doc, &cfg]() {
+    auto record = make_json_record(string_view(doc), cfg);
+  });
+  cfg.paths = { "/*/id" };
+  double projected_mbps = __measure_mbps(doc.size(), repeat, [&doc, &cfg]() {
+    auto record = make_json_record(string_view(doc), cfg);
+  });
+  cfg.strict_json = true;
+  double strict_mbps = __measure_mbps(doc.size(), repeat, [&doc, &cfg]() {
+    auto record = make_json_record(string_view(doc), cfg);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "full document : " << full_mbps << " MB/s" << endl
+       << "projected     : " << projected_mbps << " MB/s" << endl
+       << "strict        : " << strict_mbps << " MB/s" << endl;
+  ASSERT_TRUE(full_mbps > 0. && projected_mbps > 0. && strict_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_document_teardown)
+{
+  const string doc = __make_mixed_document(64 << 20);
+  const int repeat = 3;
+  double records_ms = 0., document_ms = 0.;
+  for (int i=0; i<repeat; ++i) {
+    JsonRecordPtr record = make_json_record(string_view(doc));
+    auto begin = chrono::steady_clock::now();
+    record.reset();
+    records_ms += chrono::duration<double, milli>(
+                    chrono::steady_clock::now() - begin).count();
+    JsonDocumentPtr document = make_json_document(doc);
+    begin = chrono::steady_clock::now();
+    document.reset();
+    document_ms += chrono::duration<double, milli>(
+                     chrono::steady_clock::now() - begin).count();
+  }
+  double records_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  double document_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto document = make_json_document(doc);
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "records       : " << records_mbps << " MB/s, teardown "
+       << records_ms / repeat << " ms" << endl
+       << "document      : " << document_mbps << " MB/s, teardown "
+       << document_ms / repeat << " ms" << endl;
+  ASSERT_TRUE(records_mbps > 0. && document_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_tape)
+{
+  /* parses, then sums the ids of all the elements */
+  const string doc = __make_mixed_document(64 << 20);
+  const int repeat = 3;
+  long long records_sum = 0, tape_sum = 0;
+  double records_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    JsonRecordPtr record = make_json_record(string_view(doc));
+    for (const JsonRecordPtr& item : record->as_array()) {
+      records_sum += item->as_object().at("id")->as_data().as_int();
+    }
+  });
+  size_t tape_bytes = 0;
+  double tape_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    JsonTapePtr tape = make_json_tape(doc);
+    for (JsonTapeValue item : tape->root()) {
+      tape_sum += item.at("id").as_int();
+    }
+    tape_bytes = tape->memory_usage();
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "records       : " << records_mbps << " MB/s" << endl
+       << "tape          : " << tape_mbps << " MB/s, "
+       << tape_bytes / 1024 << " KiB" << endl;
+  ASSERT_TRUE(records_sum == tape_sum && records_mbps > 0. && tape_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_value)
+{
+  /* parses, sums all the coordinates, and frees the document */
+  const string doc = __make_numeric_document(64 << 20);
+  const int repeat = 3;
+  double records_sum = 0., value_sum = 0.;
+  double records_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    JsonRecordPtr record = make_json_record(string_view(doc));
+    for (const JsonRecordPtr& point
+           : record->as_object().at("coordinates")->as_array()) {
+      for (const JsonRecordPtr& x : point->as_array()) {
+        records_sum += x->as_data().as_double();
+      }
+    }
+  });
+  double value_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    JsonValue value = make_json_value(doc);
+    for (const JsonValue& point : value.at("coordinates").as_array()) {
+      for (const JsonValue& x : point.as_array()) {
+        value_sum += x.as_double();
+      }
+    }
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "records       : " << records_mbps << " MB/s" << endl
+       << "values        : " << value_mbps << " MB/s" << endl;
+  ASSERT_TRUE(records_sum == value_sum && records_mbps > 0.
+              && value_mbps > 0.);
+}
+
+TEST(Benchmark, DISABLED_object_members)
+{
+  /* parses objects of six members, and looks three of them up */
+  const string doc = __make_mixed_document(32 << 20);
+  const int repeat = 3;
+  long long sum = 0;
+  double parse_mbps = __measure_mbps(doc.size(), repeat, [&doc]() {
+    auto record = make_json_record(string_view(doc));
+  });
+  JsonRecordPtr record = make_json_record(string_view(doc));
+  const JsonArray& array = record->as_array();
+  const string id = "id", name = "name", parent = "parent";
+  auto begin = chrono::steady_clock::now();
+  for (int i=0; i<repeat; ++i) {
+    for (const JsonRecordPtr& item : array) {
+      const JsonObject& obj = item->as_object();
+      sum += obj.at(id)->as_data().as_int() + obj.count(name)
+             + obj.count(parent);
+    }
+  }
+  double lookup_ns = chrono::duration<double, nano>(
+                       chrono::steady_clock::now() - begin).count()
+                     / (3. * repeat * array.size());
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "parse         : " << parse_mbps << " MB/s" << endl
+       << "lookup        : " << lookup_ns << " ns" << endl;
+  ASSERT_TRUE(parse_mbps > 0. && sum > 0);
+}
+
+TEST(Benchmark, DISABLED_json_key)
+{
+  /* looks eight keys up in each of many objects of 24 members */
+  JsonArrayPtr array = make_json_array();
+  for (int i=0; i<200000; ++i) {
+    JsonObjectPtr obj = make_json_object();
+    for (int j=0; j<24; ++j) {
+      (*obj)["member_" + to_string(j)] = make_json_data(i + j);
+    }
+    array->push_back(std::move(obj));
+  }
+  vector<string> names;
+  vector<JsonKey> keys;
+  for (int j=0; j<24; j+=3) {
+    names.push_back("member_" + to_string(j));
+    keys.emplace_back(names.back());
+  }
+  const int repeat = 5;
+  long long view_sum = 0, key_sum = 0;
+  auto measure_ns = [&](auto&& lookup) {
+    auto begin = chrono::steady_clock::now();
+    for (int i=0; i<repeat; ++i) {
+      for (const JsonRecordPtr& item : *array) { lookup(item->as_object()); }
+    }
+    return chrono::duration<double, nano>(
+             chrono::steady_clock::now() - begin).count()
+           / (8. * repeat * array->size());
+  };
+  double view_ns = measure_ns([&](const JsonObject& obj) {
+    for (const string& name : names) {
+      view_sum += obj.at(name)->as_data().as_int();
+    }
+  });
+  double key_ns = measure_ns([&](const JsonObject& obj) {
+    for (const JsonKey& key : keys) {
+      key_sum += obj.at(key)->as_data().as_int();
+    }
+  });
+  cout << fixed << setprecision(1)
+       << "string_view   : " << view_ns << " ns" << endl
+       << "JsonKey       : " << key_ns << " ns" << endl;
+  ASSERT_TRUE(view_sum == key_sum);
+}
+
+TEST(Benchmark, DISABLED_reclaimer)
+{
+  /* the time the owner of a large document spends dropping it */
+  const string doc = __make_mixed_document(64 << 20);
+  const int repeat = 3;
+  JsonReclaimerPtr reclaimer = make_json_reclaimer();
+  double reset_ms = 0., retire_ms = 0., drain_ms = 0.;
+  for (int i=0; i<repeat; ++i) {
+    JsonRecordPtr record = make_json_record(string_view(doc));
+    auto begin = chrono::steady_clock::now();
+    record.reset();
+    reset_ms += chrono::duration<double, milli>(
+                  chrono::steady_clock::now() - begin).count();
+    record = make_json_record(string_view(doc));
+    begin = chrono::steady_clock::now();
+    reclaimer->retire(std::move(record));
+    retire_ms += chrono::duration<double, milli>(
+                   chrono::steady_clock::now() - begin).count();
+    begin = chrono::steady_clock::now();
+    reclaimer->drain();
+    drain_ms += chrono::duration<double, milli>(
+                  chrono::steady_clock::now() - begin).count();
+  }
+  cout << fixed << setprecision(3)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "reset         : " << reset_ms / repeat << " ms" << endl
+       << "retire        : " << retire_ms / repeat << " ms" << endl
+       << "drain         : " << drain_ms / repeat << " ms" << endl;
+  ASSERT_TRUE(reclaimer->pending() == 0);
+}
+
+TEST(Benchmark, DISABLED_clone)
+{
+  /* a copy of a base document per tenant, with one field changed */
+  const string doc = "{ \"name\": \"base\", \"items\": "
+                     + __make_mixed_document(16 << 20) + " }";
+  const int tenants = 20;
+  JsonRecordPtr base = make_json_record(string_view(doc));
+  vector<JsonRecordPtr> copies;
+  auto begin = chrono::steady_clock::now();
+  for (int i=0; i<tenants; ++i) {
+    copies.push_back(base->clone());
+    copies.back()->as_object()["name"] = make_json_string(to_string(i));
+  }
+  double clone_ms = chrono::duration<double, milli>(
+                      chrono::steady_clock::now() - begin).count();
+  begin = chrono::steady_clock::now();
+  for (JsonRecordPtr& copy : copies) {
+    copy->as_object().at("items")->as_array()[0]->as_object()["id"]
+      = make_json_data(-1);
+  }
+  double modify_ms = chrono::duration<double, milli>(
+                       chrono::steady_clock::now() - begin).count();
+  cout << fixed << setprecision(3)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "clone         : " << clone_ms / tenants << " ms" << endl
+       << "modify        : " << modify_ms / tenants << " ms" << endl;
+  ASSERT_TRUE(base->as_object().at("items")->as_array()[0]->as_object()
+                .at("id")->as_data().as_int() == 0);
+}
+
+TEST(Benchmark, DISABLED_write_text)
+{
+  const string doc = __make_mixed_document(64 << 20);
+  const JsonRecordPtr record = make_json_record(string_view(doc));
+  const int repeat = 3;
+  size_t pretty_size = 0, compact_size = 0;
+  double pretty_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    stringstream ss;
+    write_json_text(ss, record);
+    pretty_size = ss.tellp();
+  });
+  s_config_t cfg;
+  cfg.compact = true;
+  double compact_mbps = __measure_mbps(doc.size(), repeat, [&]() {
+    stringstream ss;
+    write_json_text(ss, record, cfg);
+    compact_size = ss.tellp();
+  });
+  cout << fixed << setprecision(1)
+       << "document size : " << doc.size() / 1024 << " KiB" << endl
+       << "pretty        : " << pretty_mbps << " MB/s, "
+       << pretty_size / 1024 << " KiB" << endl
+       << "compact       : " << compact_mbps << " MB/s, "
+       << compact_size / 1024 << " KiB" << endl;
+  ASSERT_TRUE(compact_size < pretty_size && compact_mbps > 0.);
+}
@@ -0,0 +1,141 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace J5Serdes;
+using namespace std;
+
+TEST(JsonDocument, parity_with_records)
+{
+  JsonDocumentPtr doc = make_json_document(__sample_document);
+  string expected = __serialize(make_json_record(__sample_document).get());
+  ASSERT_TRUE(__serialize(doc->root().get()) == expected);
+
+  d_config_t cfg;
+  cfg.strict_json = true;
+  JsonDocumentPtr strict = make_json_document(__sample_document, cfg);
+  ASSERT_TRUE(__serialize(strict->root().get()) == expected);
+
+  char path[] = "/tmp/utest-json-document-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  string text(__sample_document);
+  ASSERT_TRUE(write(fd, text.data(), text.size())
+              == static_cast<ssize_t>(text.size()));
+  close(fd);
+  JsonDocumentPtr from_file = make_json_document_from_file(path);
+  unlink(path);
+  ASSERT_TRUE(__serialize(from_file->root().get()) == expected);
+
+  cfg.lazy = true;
+  bool thrown = false;
+  try { make_json_document(__sample_document, cfg); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonDocument, modify)
+{
+  JsonDocumentPtr doc = make_json_document(__sample_document);
+  JsonObject& root = doc->root()->as_object();
+  /* records of the document, of the heap, and clones taken out of it */
+  JsonRecordPtr items = root.at("items")->clone();
+  root.erase("items");
+  root.at("tags") = make_json_data(3);
+  JsonArrayPtr array = doc->make_array();
+  array->push_back(doc->make_data(1));
+  array->push_back(doc->make_string("a string longer than the inline buffer"));
+  array->push_back(make_json_string("heap"));
+  array->push_back(doc->make_data());
+  root.insert("array", std::move(array));
+  JsonObjectPtr object = doc->make_object();
+  (*object)["x"] = doc->make_data(2.5);
+  (*object)["x"] = doc->make_data(true);
+  root["object"] = std::move(object);
+  root.insert("copy", root.at("array"));
+
+  JsonRecordPtr expected = make_json_record(
+    R"({ "id": 12, "name": "a \"quoted\" name longer than fifteen bytes",
+         "ratio": 0.25, "tags": 3, "ok": true, "no": false, "parent": null,
+         "big": -9007199254740993,
+         "array": [ 1, "a string longer than the inline buffer", "heap",
+                    null ],
+         "object": { "x": true },
+         "copy": [ 1, "a string longer than the inline buffer", "heap",
+                   null ] })");
+  ASSERT_TRUE(__serialize(doc->root().get()) == __serialize(expected.get()));
+  /* an array of the document which handed out an element, then cloned */
+  const JsonObject& const_root = doc->root()->as_object();
+  const JsonRecord* element = const_root.at("array")->as_array()[1];
+  JsonRecordPtr array_copy = const_root.at("array")->clone();
+  ASSERT_TRUE(element == const_root.at("array")->as_array()[1]);
+  doc.reset();
+  ASSERT_TRUE(array_copy->as_array()[1]->as_string().to_string()
+              == "a string longer than the inline buffer");
+  ASSERT_TRUE(items->as_array().size() == 2);
+  ASSERT_TRUE(items->as_array()[0]->as_object().at("sku")->as_string()
+                .to_string() == "x1");
+
+  /* a root made elsewhere */
+  doc = make_json_document();
+  doc->root() = make_json_record(__sample_document);
+  doc->root() = doc->make_object();
+  doc->root()->as_object().insert("id", doc->make_data(1));
+  ASSERT_TRUE(doc->root()->as_object().at("id")->as_data().as_int() == 1);
+}
+
+TEST(JsonDocument, large_document)
+{
+  string text = "[";
+  for (int i=0; i<200000; ++i) {
+    text += string(i ? "," : "") + "{\"id\":" + to_string(i)
+            + ",\"name\":\"element number " + to_string(i) + "\""
+            + ",\"tags\":[1,2,3]}";
+  }
+  text += "]";
+  d_config_t cfg;
+  cfg.strict_json = true;
+  cfg.parallel = true;
+  cfg.threads = 4;
+  JsonDocumentPtr doc = make_json_document(text, cfg);
+  const JsonArray& array = doc->root()->as_array();
+  ASSERT_TRUE(array.size() == 200000);
+  ASSERT_TRUE(array[123456]->as_object().at("name")->as_string().to_string()
+              == "element number 123456");
+}
+
+TEST(JsonReclaimer, retire_and_drain)
+{
+  JsonReclaimerPtr reclaimer = make_json_reclaimer();
+  reclaimer->retire(nullptr);
+  reclaimer->drain();
+  ASSERT_TRUE(reclaimer->pending() == 0);
+
+  /* records from several threads, with the owners keeping nothing */
+  string doc = "[";
+  for (int i=0; i<1000; ++i) {
+    doc += string(i ? "," : "") + "{ \"id\": " + to_string(i)
+           + ", \"tags\": [ \"a\", [ \"b\" ] ] }";
+  }
+  doc += "]";
+  vector<thread> threads;
+  for (int t=0; t<4; ++t) {
+    threads.emplace_back([&reclaimer, &doc]() {
+      for (int i=0; i<20; ++i) {
+        reclaimer->retire(make_json_record(doc));
+      }
+    });
+  }
+  for (thread& t : threads) { t.join(); }
+  reclaimer->drain();
+  ASSERT_TRUE(reclaimer->pending() == 0);
+
+  /* records still retired are deleted with the reclaimer */
+  for (int i=0; i<10; ++i) { reclaimer->retire(make_json_record(doc)); }
+  reclaimer.reset();
+}
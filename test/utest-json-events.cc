@@ -0,0 +1,77 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+/* records the events as one line of text */
+class event_log_t : public JsonHandler {
+public:
+  string log;
+
+  void on_object_begin() { log += "{ "; }
+  void on_object_end() { log += "} "; }
+  void on_array_begin() { log += "[ "; }
+  void on_array_end() { log += "] "; }
+  void on_key(string_view key) { log += "key:" + string(key) + " "; }
+  void on_string(string_view value) { log += "str:" + string(value) + " "; }
+  void on_number(double value) { log += "num:" + to_string(value) + " "; }
+  void on_integer(long long value)
+    { log += "int:" + to_string(value) + " "; }
+  void on_bool(bool value) { log += value ? "true " : "false "; }
+  void on_null() { log += "null "; }
+};
+
+static const char* __document =
+  R"({ "id": 12, "name": "a\tb", "price": 2.5,
+       "tags": [ "x", [], {} ], "ok": true, "parent": null })";
+
+static const char* __expected_log =
+  "{ key:id int:12 key:name str:a\tb key:price num:2.500000 "
+  "key:tags [ str:x [ ] { } ] key:ok true key:parent null } ";
+
+TEST(JsonEvents, event_sequence)
+{
+  event_log_t from_buffer;
+  parse_json_events(__document, from_buffer);
+  ASSERT_TRUE(from_buffer.log == __expected_log);
+
+  istringstream istrm(__document);
+  event_log_t from_istream;
+  parse_json_events(istrm, from_istream);
+  ASSERT_TRUE(from_istream.log == __expected_log);
+
+  d_config_t strict_cfg;
+  strict_cfg.strict_json = true;
+  event_log_t from_strict;
+  parse_json_events(__document, from_strict, strict_cfg);
+  ASSERT_TRUE(from_strict.log == __expected_log);
+}
+
+TEST(JsonEvents, push_parser_events)
+{
+  string doc(__document);
+  for (size_t chunk_size=1; chunk_size<=doc.size(); ++chunk_size) {
+    event_log_t handler;
+    JsonPushParserPtr parser = make_json_push_parser(handler);
+    for (size_t pos=0; pos<doc.size(); pos+=chunk_size) {
+      parser->feed(doc.data() + pos, min(chunk_size, doc.size() - pos));
+    }
+    ASSERT_TRUE(!parser->finish());
+    ASSERT_TRUE(handler.log == __expected_log);
+  }
+}
+
+TEST(JsonEvents, default_handler)
+{
+  /* integers reach on_number() unless on_integer() is overridden */
+  struct sum_t : public JsonHandler {
+    double sum = 0.;
+    void on_number(double value) { sum += value; }
+  } handler;
+  parse_json_events("[ 1, 2.5, { \"a\": -4, \"b\": \"7\" } ]", handler);
+  ASSERT_TRUE(handler.sum == -0.5);
+}
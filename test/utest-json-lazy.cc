@@ -0,0 +1,141 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace J5Serdes;
+using namespace std;
+
+static const char* __document = R"(// routing payload
+{ "route": "/v1/items", id: 0x2A, "price": -2.5e-1, 'quoted': "a\"b\u00e9",
+  "items": [ { "id": 1, "tags": [ "x", [] ] }, { "id": 2, "tags": {} } ],
+  "flags": [ true, false, null ], "empty": {}, })";
+
+TEST(JsonLazy, parity_with_eager)
+{
+  JsonRecordPtr eager = make_json_record(__document);
+  ASSERT_TRUE(__serialize(make_json_record(__document, __lazy_config()))
+              == __serialize(eager));
+
+  istringstream istrm(__document);
+  ASSERT_TRUE(__serialize(make_json_record(istrm, __lazy_config()))
+              == __serialize(eager));
+
+  char path[] = "/tmp/utest-json-lazy-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  string doc(__document);
+  ASSERT_TRUE(write(fd, doc.data(), doc.size())
+              == static_cast<ssize_t>(doc.size()));
+  close(fd);
+  JsonRecordPtr from_file = make_json_record_from_file(path, __lazy_config());
+  unlink(path);
+  ASSERT_TRUE(__serialize(from_file) == __serialize(eager));
+
+  JsonPushParserPtr parser = make_json_push_parser(__lazy_config());
+  parser->feed(doc);
+  ASSERT_TRUE(__serialize(parser->finish()) == __serialize(eager));
+}
+
+TEST(JsonLazy, access_on_demand)
+{
+  /* the syntax errors are in values that are never accessed */
+  JsonRecordPtr record;
+  {
+    string doc = R"({ "id": 7, "bad": [ 1, 2 3 ], "name": "n",
+                      "nested": { "ok": [ 1, { "deep": "x" } ], "no": 1x } })";
+    record = make_json_record(doc, __lazy_config());
+  }
+  /* the input was copied, and outlives the string */
+  const JsonObject& obj = record->as_object();
+  ASSERT_TRUE(obj.size() == 4);
+  ASSERT_TRUE(obj.at("id")->as_data().as_int() == 7);
+  ASSERT_TRUE(obj.at("name")->as_string().to_string() == "n");
+  const JsonObject& nested = obj.at("nested")->as_object();
+  ASSERT_TRUE(nested.at("ok")->as_array()[1]->as_object().at("deep")
+              ->as_string().to_string() == "x");
+  for (int i=0; i<2; ++i) {
+    bool thrown = false;
+    try { obj.at("bad")->as_array().size(); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+    thrown = false;
+    try { nested.at("no")->as_data().as_int(); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+
+  bool thrown = false;
+  try { make_json_record("[ 1, 2 ] 3", __lazy_config()); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonLazy, copy_and_modify)
+{
+  JsonRecordPtr record = make_json_record(__document, __lazy_config());
+  JsonRecordPtr copy = record->clone();
+  JsonObject& items0 = record->as_object().at("items")->as_array()[0]
+                         ->as_object();
+  items0.insert("added", make_json_string("v"));
+  items0.erase("tags");
+  ASSERT_TRUE(items0.size() == 2);
+  ASSERT_TRUE(copy->as_object().at("items")->as_array()[0]->as_object()
+              .count("tags") == 1);
+  ASSERT_TRUE(__serialize(copy)
+              == __serialize(make_json_record(__document)));
+
+  JsonObjectPtr assigned = make_json_object();
+  *assigned = record->as_object().at("items")->as_array()[1]->as_object();
+  ASSERT_TRUE(assigned->at("id")->as_data().as_int() == 2);
+}
+
+TEST(JsonLazy, strict_json)
+{
+  d_config_t cfg = __lazy_config();
+  cfg.strict_json = true;
+  JsonRecordPtr record = make_json_record(R"({ "a": [ 1, 2.5 ] })", cfg);
+  ASSERT_TRUE(record->as_object().at("a")->as_array()[1]->as_data()
+              .as_double() == 2.5);
+  bool thrown = false;
+  try { make_json_record(R"({ "a": [ 1, { b: 2 } ] })", cfg); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonLazy, concurrent_reads)
+{
+  /* each value is parsed by one of the threads reading it */
+  string doc = "[";
+  for (int i=0; i<2000; ++i) {
+    doc += string(i ? "," : "") + "{ \"id\": " + to_string(i)
+           + ", \"name\": \"item " + to_string(i) + "\", \"tags\": [ 1, [] ] }";
+  }
+  doc += "]";
+  string expected = __serialize(make_json_record(doc));
+  for (int round=0; round<5; ++round) {
+    JsonRecordPtr record = make_json_record(doc, __lazy_config());
+    const JsonRecord& root = *record;
+    vector<string> texts(4);
+    vector<thread> threads;
+    for (size_t t=0; t<texts.size(); ++t) {
+      threads.emplace_back([&record, &root, &texts, t]() {
+        const JsonArray& items = root.as_array();
+        int64_t total = 0;
+        for (size_t i=0; i<items.size(); ++i) {
+          const JsonRecord& item = *items[(i + t * 500) % items.size()];
+          total += item.as_object().at("id")->as_data().as_int();
+        }
+        texts[t] = t % 2 ? __serialize(root.clone()) : __serialize(record);
+        if (total != 1999 * 2000 / 2) { texts[t].clear(); }
+      });
+    }
+    for (thread& th : threads) { th.join(); }
+    for (const string& text : texts) { ASSERT_TRUE(text == expected); }
+  }
+}
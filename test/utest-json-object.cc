@@ -1,10 +1,15 @@
 #include "minitest.h"
 #include "j5serdes.h"
+#include "test-util.h"
+#include "alloc-counter.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <streambuf>
 #include <istream>
 #include <sstream>
+#include <thread>
+#include <unistd.h>
 
 using namespace J5Serdes;
 using namespace std;
@@ -220,3 +225,524 @@ TEST(JsonObject, object_deserialize_deep_nesting)
   //write_json_text(cout, object);
   //cout << endl;
 }
+
+TEST(JsonObject, buffer_deserialize)
+{
+  const char* json_strs[] = {
+    R"( /* comment **/ "double quoted string with escape \t" )",
+    R"( -3.141592653589793238462643 )",
+    R"(+0x7f)",
+    R"( [ 1.00001, [ 2, 3, 4 ], '5', "6", 0x7, +8, 9, '0x"A"' ] )",
+    R"( { "one": 1, // line comment
+          'two': { item1 : 0.3125, 'item2' : "bé😀" },
+          three: [ '1', 2, "san" ], } )",
+  };
+  for (const char* json_str : json_strs) {
+    string_view sv(json_str);
+    string_view_istream istrm(sv);
+    stringstream from_stream, from_buffer, from_pointer;
+    write_json_text(from_stream, make_json_record(istrm));
+    write_json_text(from_buffer, make_json_record(sv));
+    write_json_text(from_pointer, make_json_record(sv.data(), sv.size()));
+    ASSERT_TRUE(from_stream.str() == from_buffer.str());
+    ASSERT_TRUE(from_stream.str() == from_pointer.str());
+  }
+  auto record = make_json_record(string_view("[ 1, 2, 3 ]"));
+  ASSERT_TRUE(record->as_array().size() == 3);
+  ASSERT_TRUE(record->as_array()[2]->as_data().as_int() == 3);
+  ASSERT_TRUE(make_json_record(string_view("  ")) == nullptr);
+  bool thrown = false;
+  try { make_json_record(string_view("[ 'unterminated ]")); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonObject, file_deserialize)
+{
+  char path[] = "/tmp/utest-json-object-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  const string json_str = R"({ one: 1, "two": [ 2, '2' ], three: "san" })";
+  ASSERT_TRUE(write(fd, json_str.data(), json_str.size())
+              == static_cast<ssize_t>(json_str.size()));
+  close(fd);
+  auto record = make_json_record_from_file(path);
+  unlink(path);
+  ASSERT_TRUE(record->type() == JsonRecord::Type::OBJECT);
+  ASSERT_TRUE(record->as_object().size() == 3);
+  ASSERT_TRUE(record->as_object().at("three")->as_string().to_string()
+              == "san");
+  bool thrown = false;
+  try { make_json_record_from_file(path); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonObject, string_deserialize)
+{
+  /* escapes at every offset around the 16 and 32 byte scan widths */
+  for (int pad=0; pad<70; ++pad) {
+    string filler(pad, 'x');
+    string json_str = "[ \"" + filler + "\\\"\\\\\\n\\u00e9\\ud83d\\ude00"
+                      + filler + "\", '" + filler + "\\'\"\\\n" + filler
+                      + "' ]";
+    string expected0 = filler + "\"\\\n\xc3\xa9\xf0\x9f\x98\x80" + filler;
+    string expected1 = filler + "'\"" + filler;
+    string_view sv(json_str);
+    string_view_istream istrm(sv);
+    auto from_stream = make_json_record(istrm);
+    auto from_buffer = make_json_record(sv);
+    for (auto* record : { from_stream.get(), from_buffer.get() }) {
+      auto& array = record->as_array();
+      ASSERT_TRUE(array.size() == 2);
+      ASSERT_TRUE(array[0]->as_string().to_string() == expected0);
+      ASSERT_TRUE(array[1]->as_string().to_string() == expected1);
+    }
+  }
+  const char* invalid_strs[] = {
+    R"("\u12G4")", R"("\ud83d")", R"("\ud83d\u0041")", R"("\q")",
+    R"("\u12)", R"('abc\')",
+  };
+  for (const char* json_str : invalid_strs) {
+    bool thrown = false;
+    try { make_json_record(string_view(json_str)); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+    thrown = false;
+    string_view_istream istrm(json_str);
+    try { make_json_record(istrm); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+}
+
+TEST(JsonObject, number_deserialize)
+{
+  const char* json_str = R"([ 1e5, -2.5E-3, +0x7f, -0x10, .5, 5., 0.1,
+    9223372036854775807, -9223372036854775808, 123456789012345678901234567890.,
+    3.141592653589793, 1.7976931348623157e308, 4.9e-324, +12, 010, -0 ])";
+  string_view sv(json_str);
+  string_view_istream istrm(sv);
+  auto from_stream = make_json_record(istrm);
+  auto from_buffer = make_json_record(sv);
+  for (auto* record : { from_stream.get(), from_buffer.get() }) {
+    auto& array = record->as_array();
+    ASSERT_TRUE(array.size() == 16);
+    ASSERT_TRUE(array[0]->as_data().to_string() == "100000.000000");
+    ASSERT_TRUE(array[1]->as_data().as_double() == -2.5E-3);
+    ASSERT_TRUE(array[2]->as_data().as_int() == 127);
+    ASSERT_TRUE(array[3]->as_data().as_int() == -16);
+    ASSERT_TRUE(array[4]->as_data().as_double() == .5);
+    ASSERT_TRUE(array[5]->as_data().as_double() == 5.);
+    ASSERT_TRUE(array[6]->as_data().as_double() == 0.1);
+    ASSERT_TRUE(array[7]->as_data().as_int() == 9223372036854775807LL);
+    ASSERT_TRUE(array[8]->as_data().as_int() == -9223372036854775807LL - 1);
+    ASSERT_TRUE(array[9]->as_data().as_double()
+                == 123456789012345678901234567890.);
+    ASSERT_TRUE(array[10]->as_data().as_double() == 3.141592653589793);
+    ASSERT_TRUE(array[11]->as_data().as_double() == 1.7976931348623157e308);
+    ASSERT_TRUE(array[12]->as_data().as_double() == 4.9e-324);
+    ASSERT_TRUE(array[13]->as_data().to_string() == "12");
+    ASSERT_TRUE(array[14]->as_data().as_int() == 10);
+    ASSERT_TRUE(array[15]->as_data().to_string() == "0");
+  }
+  auto hex_bounds = make_json_record(
+    string_view("[ 0x7FFFFFFFFFFFFFFF, -0x8000000000000000 ]"));
+  ASSERT_TRUE(hex_bounds->as_array()[0]->as_data().as_int()
+              == 9223372036854775807LL);
+  ASSERT_TRUE(hex_bounds->as_array()[1]->as_data().as_int()
+              == -9223372036854775807LL - 1);
+
+  const char* invalid_strs[] = {
+    "[ 1x ]", "[ + ]", "[ +-1 ]", "[ 1e ]", "[ 1.2.3 ]", "[ 0x ]", "[ . ]",
+    "[ 1e999 ]", "[ abc ]",
+    /* integers out of the int64 range, rather than rounded to doubles */
+    "[ 9223372036854775808 ]", "[ -9223372036854775809 ]",
+    "[ 18446744073709551615 ]", "[ 123456789012345678901234567890 ]",
+    "[ 0xFFFFFFFFFFFFFFFF ]", "[ 0x8000000000000000 ]",
+    "[ -0x8000000000000001 ]",
+  };
+  for (const char* invalid_str : invalid_strs) {
+    bool thrown = false;
+    try { make_json_record(string_view(invalid_str)); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+}
+
+TEST(JsonObject, string_pool)
+{
+  const string long_value = "application/json; charset=utf-8";
+  string doc = "[";
+  for (int i=0; i<100; ++i) {
+    doc += string(i ? "," : "") + "{ \"type\": \"" + long_value
+           + "\", \"tag\": \"x\", \"id\": \"" + to_string(i) + string(20, '.')
+           + "\", \"the keys of the members are not pooled\": 0 }";
+  }
+  doc += "]";
+  d_config_t cfg;
+  cfg.string_pool = make_json_string_pool();
+  JsonRecordPtr record = make_json_record(doc, cfg);
+  /* neither short strings nor keys are pooled */
+  ASSERT_TRUE(cfg.string_pool->size() == 101);
+  const JsonArray& array = record->as_array();
+  ASSERT_TRUE(&array[0]->as_object().at("type")->as_string().to_string()
+              == &array[99]->as_object().at("type")->as_string().to_string());
+  ASSERT_TRUE(array[7]->as_object().at("id")->as_string().to_string()
+              == "7" + string(20, '.'));
+
+  /* the records outlive the pool, and later documents share its strings */
+  JsonRecordPtr copy = make_json_record(doc, cfg);
+  cfg.string_pool->clear();
+  cfg.string_pool.reset();
+  ASSERT_TRUE(&copy->as_array()[0]->as_object().at("type")->as_string()
+                 .to_string()
+              == &array[0]->as_object().at("type")->as_string().to_string());
+  ASSERT_TRUE(copy->as_array()[3]->as_object().at("type")->as_string()
+                .to_string() == long_value);
+
+  /* the keys of an object stay valid when members come and go */
+  JsonObject& obj = record->as_array()[0]->as_object();
+  obj.erase("tag");
+  obj.insert("a key longer than the inline capacity", make_json_data(1));
+  obj.erase(obj.find("type"));
+  ASSERT_TRUE(obj.size() == 3 && obj.count("id") && !obj.count("type"));
+  ASSERT_TRUE(obj.at("a key longer than the inline capacity")->as_data()
+                .as_int() == 1);
+
+  cfg.intern_strings = true;
+  record = make_json_record(doc, cfg);
+  ASSERT_TRUE(&record->as_array()[0]->as_object().at("type")->as_string()
+                 .to_string()
+              == &record->as_array()[1]->as_object().at("type")->as_string()
+                   .to_string());
+  /* a value of the document's own pool outlives the document */
+  JsonRecordPtr type = record->as_array()[5]->as_object().at("type")->clone();
+  record.reset();
+  ASSERT_TRUE(type->as_string().to_string() == long_value);
+
+  /* and pooled values are allocated in the arenas of documents */
+  JsonDocumentPtr document = make_json_document(doc, cfg);
+  const JsonArray& elements = document->root()->as_array();
+  ASSERT_TRUE(&elements[2]->as_object().at("type")->as_string().to_string()
+              == &elements[9]->as_object().at("type")->as_string()
+                    .to_string());
+  ASSERT_TRUE(elements[9]->as_object().at("id")->as_string().to_string()
+              == "9" + string(20, '.'));
+}
+
+TEST(JsonObject, member_index)
+{
+  /* objects cross the index threshold both ways, and keep their order */
+  auto obj = make_json_object();
+  vector<string> keys;
+  unsigned seed = 7;
+  for (int round=0; round<2000; ++round) {
+    seed = seed * 1103515245 + 12345;
+    string key = "k" + to_string(seed % 97);
+    auto it = find(keys.begin(), keys.end(), key);
+    if (seed & 0x10000) {
+      ASSERT_TRUE(obj->erase(key) == (it != keys.end() ? 1u : 0u));
+      if (it != keys.end()) { keys.erase(it); }
+    } else if (seed & 0x20000) {
+      bool inserted = obj->insert(key, make_json_data(round)).second;
+      ASSERT_TRUE(inserted == (it == keys.end()));
+      if (inserted) { keys.push_back(key); }
+    } else {
+      if (it == keys.end()) { keys.push_back(key); }
+      (*obj)[key] = make_json_data(round);
+    }
+    ASSERT_TRUE(obj->size() == keys.size());
+    if (round % 50 == 0) {
+      size_t i = 0;
+      for (auto& member : *obj) {
+        ASSERT_TRUE(member.first == keys[i]);
+        ASSERT_TRUE(obj->find(keys[i])->first == keys[i]);
+        ++ i;
+      }
+      for (int j=0; j<97; ++j) {
+        string k = "k" + to_string(j);
+        ASSERT_TRUE(obj->count(k)
+                    == (find(keys.begin(), keys.end(), k) != keys.end()));
+      }
+    }
+  }
+
+  /* copies and moves keep a working index */
+  for (int i=0; i<100; ++i) { (*obj)["n" + to_string(i)] = make_json_data(i); }
+  JsonRecordPtr copy = obj->clone();
+  JsonObjectPtr moved_ptr = make_json_object(std::move(*obj));
+  JsonObject& moved = *moved_ptr;
+  ASSERT_TRUE(obj->empty() && obj->find("n1") == obj->end());
+  ASSERT_TRUE(moved.at("n99")->as_data().as_int() == 99);
+  ASSERT_TRUE(copy->as_object().at("n42")->as_data().as_int() == 42);
+  moved.erase(moved.find("n99"));
+  ASSERT_TRUE(moved.count("n99") == 0 && moved.count("n98") == 1);
+  moved.clear();
+  ASSERT_TRUE(moved.find("n1") == moved.end());
+
+  bool thrown = false;
+  try { copy->as_object().at("missing"); }
+  catch (const out_of_range&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonObject, string_view_keys)
+{
+  /* keys sliced from a buffer, in small and indexed objects */
+  const string buffer = "id,name,k17,missing";
+  string_view id(buffer.data(), 2), name(buffer.data() + 3, 4),
+              k17(buffer.data() + 8, 3), missing(buffer.data() + 12, 7);
+  for (int n : { 4, 40 }) {
+    JsonObjectPtr obj = make_json_object();
+    obj->insert("id", make_json_data(1));
+    (*obj)[name] = make_json_string("ann");
+    for (int i=0; i<n; ++i) { (*obj)["k" + to_string(i)] = make_json_data(i); }
+    const JsonObject& cobj = *obj;
+    ASSERT_TRUE(cobj.at(id)->as_data().as_int() == 1);
+    ASSERT_TRUE(cobj.find(name)->second->as_string().to_string() == "ann");
+    ASSERT_TRUE(obj->find(missing) == obj->end());
+    ASSERT_TRUE(cobj.count(k17) == (n > 17 ? 1u : 0u));
+    ASSERT_TRUE(obj->erase(id) == 1 && obj->erase(id) == 0);
+    (*obj)[id] = make_json_data(2);
+    ASSERT_TRUE(prev(obj->end())->first == "id");
+    ASSERT_TRUE(obj->size() == static_cast<size_t>(n) + 2);
+  }
+}
+
+TEST(JsonObject, json_key)
+{
+  static const JsonKey key_id("id"), key_k17("k17"), key_missing("missing");
+  ASSERT_TRUE(JsonKey(string("id")).hash() == key_id.hash());
+  ASSERT_TRUE(key_id.str() == "id");
+  for (int n : { 4, 40 }) {
+    JsonObjectPtr obj = make_json_object();
+    for (int i=0; i<n; ++i) { (*obj)["k" + to_string(i)] = make_json_data(i); }
+    (*obj)["id"] = make_json_data(-1);
+    const JsonObject& cobj = *obj;
+    ASSERT_TRUE(cobj.at(key_id)->as_data().as_int() == -1);
+    ASSERT_TRUE(obj->find(key_id) == obj->find("id"));
+    ASSERT_TRUE(cobj.find(key_missing) == cobj.end());
+    ASSERT_TRUE(cobj.count(key_k17) == (n > 17 ? 1u : 0u));
+    obj->at(key_id) = make_json_data(5);
+    ASSERT_TRUE(obj->at("id")->as_data().as_int() == 5);
+    bool thrown = false;
+    try { obj->at(key_missing); }
+    catch (const out_of_range&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+}
+
+TEST(JsonObject, clone_sharing)
+{
+  static const char* doc =
+    R"({ "name": "base", "limits": { "cpu": 2, "disk": [ 10, 20 ] },
+         "tags": [ "a", { "b": 1 } ] })";
+  JsonRecordPtr base = make_json_record(doc);
+  string base_text = __serialize(base);
+
+  /* clones share the members left alone on both sides: cloning copies
+   * nothing, and a handle on a member copies the level it is taken from */
+  size_t before = __allocations;
+  JsonRecordPtr tenant = base->clone();
+  ASSERT_TRUE(__allocations == before);
+  const JsonObject& cbase = base->as_object();
+  const JsonObject& ctenant = tenant->as_object();
+  before = __allocations;
+  ASSERT_TRUE(ctenant.at("limits") != cbase.at("limits"));
+  ASSERT_TRUE(__allocations - before <= 2 * (1 + 3));  /* bodies, nodes */
+  tenant->as_object().at("limits")->as_object()["cpu"] = make_json_data(8);
+  tenant->as_object().erase("name");
+  ASSERT_TRUE(__serialize(base) == base_text);
+  ASSERT_TRUE(tenant->as_object().at("limits")->as_object().at("cpu")
+                ->as_data().as_int() == 8);
+  ASSERT_TRUE(ctenant.count("name") == 0);
+
+  /* a const handle taken on a clone follows its later modifications, and
+   * outlives the source */
+  {
+    JsonRecordPtr base = make_json_record(doc);
+    JsonRecordPtr tenant = base->clone();
+    const JsonObject& ctenant = tenant->as_object();
+    const JsonRecord* h = ctenant.at("limits");
+    tenant->as_object()["b"] = make_json_data(1);
+    tenant->as_object().at("limits")->as_object()["cpu"] = make_json_data(9);
+    ASSERT_TRUE(h->as_object().at("cpu")->as_data().as_int() == 9);
+    base.reset();
+    ASSERT_TRUE(h->as_object().at("cpu")->as_data().as_int() == 9);
+    ASSERT_TRUE(h == ctenant.at("limits"));
+  }
+
+  /* and from several threads at once, reading the clone meanwhile, as the
+   * source goes on another one */
+  for (int round=0; round<20; ++round) {
+    JsonRecordPtr base = make_json_record(doc);
+    JsonRecordPtr tenant = base->clone();
+    const JsonRecord& ctenant = *tenant;
+    vector<const JsonRecord*> handles(4);
+    vector<string> texts(handles.size());
+    vector<thread> threads;
+    for (size_t t=0; t<handles.size(); ++t) {
+      threads.emplace_back([&ctenant, &handles, &texts, t]() {
+        if (t % 2) { texts[t] = __serialize(&ctenant); }
+        handles[t] = ctenant.as_object().at("limits");
+        texts[t] = __serialize(handles[t]);
+      });
+    }
+    threads.emplace_back([&base]() {
+      base->as_object().at("limits")->as_object()["cpu"] = make_json_data(1);
+      base.reset();
+    });
+    for (thread& th : threads) { th.join(); }
+    for (size_t t=0; t<handles.size(); ++t) {
+      ASSERT_TRUE(handles[t] == handles[0] && texts[t] == texts[0]);
+    }
+    tenant->as_object().at("limits")->as_object()["cpu"] = make_json_data(3);
+    ASSERT_TRUE(handles[0]->as_object().at("cpu")->as_data().as_int() == 3);
+  }
+
+  /* and the source modified instead */
+  JsonRecordPtr copy = make_json_object(cbase);
+  base->as_object().at("tags")->as_array().push_back(make_json_data());
+  ASSERT_TRUE(__serialize(copy) == base_text);
+
+  /* handles kept on the members still modify their record only */
+  JsonRecordPtr& limits = base->as_object().at("limits");
+  JsonArrayPtr array = make_json_array();
+  JsonArray* kept = array.get();
+  base->as_object().insert("array", std::move(array));
+  JsonRecordPtr other = base->clone();
+  string other_text = __serialize(other);
+  limits = make_json_data(1);
+  kept->push_back(make_json_data(2));
+  ASSERT_TRUE(__serialize(other) == other_text);
+  JsonArrayPtr nested = make_json_array();
+  JsonArray* nested_kept = nested.get();
+  kept->push_back(std::move(nested));
+  JsonRecordPtr kept_copy = kept->clone();
+  nested_kept->push_back(make_json_data(3));
+  ASSERT_TRUE(__serialize(kept_copy)
+              == __serialize(make_json_record("[ 2, [] ]")));
+
+  /* iterators of a shared body still erase their member */
+  JsonRecordPtr source = make_json_record(doc);
+  JsonRecordPtr clone = source->clone();
+  const JsonRecord& csource = *source;
+  JsonObject::const_iterator it = csource.as_object().find("tags");
+  source->as_object().erase(it);
+  ASSERT_TRUE(source->as_object().count("tags") == 0);
+  ASSERT_TRUE(clone->as_object().count("tags") == 1);
+  ASSERT_TRUE(__serialize(clone) == __serialize(make_json_record(doc)));
+
+  /* const handles taken before a clone keep following their record */
+  JsonRecordPtr record = make_json_record(doc);
+  const JsonObject& crecord = record->as_object();
+  const JsonRecord* climits = crecord.at("limits");
+  JsonObject::const_iterator ctags = crecord.find("tags");
+  const JsonArray& ctags_array = static_cast<const JsonRecord&>(
+                                   *ctags->second).as_array();
+  const JsonRecord* ctag = ctags_array[1];
+  JsonRecordPtr record_clone = record->clone();
+  record->as_object().at("limits")->as_object()["cpu"] = make_json_data(4);
+  record->as_object().at("tags")->as_array()[1]->as_object()["b"]
+    = make_json_data(5);
+  ASSERT_TRUE(climits->as_object().at("cpu")->as_data().as_int() == 4);
+  ASSERT_TRUE(ctags_array[1] == ctag && ctags_array.size() == 2);
+  ASSERT_TRUE(ctag->as_object().at("b")->as_data().as_int() == 5);
+  ASSERT_TRUE(__serialize(record_clone) == __serialize(make_json_record(doc)));
+}
+
+TEST(JsonObject, member_allocations)
+{
+  /* keys too long to be stored inline by std::string */
+  const size_t n = 12, n_indexed = 40;
+  vector<string> names, keys;
+  vector<JsonRecordPtr> values;
+  for (size_t i=0; i<n_indexed; ++i) {
+    names.push_back("a member key longer than sso " + to_string(i));
+    keys.push_back(names.back());
+    values.push_back(make_json_data());
+  }
+
+  /* the list node only, with the key moved in */
+  JsonObjectPtr obj = make_json_object();
+  size_t before = __allocations;
+  for (size_t i=0; i<n; ++i) {
+    obj->try_emplace(std::move(keys[i]), std::move(values[i]));
+  }
+  ASSERT_TRUE(__allocations - before == n);
+
+  /* and the key copied, by views */
+  JsonObjectPtr copied = make_json_object();
+  before = __allocations;
+  for (size_t i=0; i<n; ++i) { (*copied)[names[i]] = nullptr; }
+  ASSERT_TRUE(__allocations - before == 2 * n);
+
+  /* none for keys found, which leave the record alone */
+  JsonRecordPtr v = make_json_data(2);
+  before = __allocations;
+  for (size_t i=0; i<n; ++i) {
+    ASSERT_TRUE(!obj->insert(names[i], std::move(v)).second && v);
+    ASSERT_TRUE(!obj->try_emplace(std::move(names[i]),
+                                  JsonRecord::Type::OBJECT).second);
+    ASSERT_TRUE(!names[i].empty());
+  }
+  ASSERT_TRUE(__allocations == before);
+
+  /* the index, sized by doubling */
+  JsonObjectPtr indexed = make_json_object();
+  before = __allocations;
+  for (size_t i=n; i<n_indexed; ++i) {
+    indexed->try_emplace(std::move(keys[i]), std::move(values[i]));
+  }
+  ASSERT_TRUE(__allocations - before <= n_indexed - n + 2);
+
+  /* children made in place, and strings taking their buffer */
+  before = __allocations;
+  auto emplaced = obj->try_emplace("child", JsonRecord::Type::ARRAY);
+  ASSERT_TRUE(emplaced.second);
+  emplaced.first->second->as_array().emplace_back(JsonRecord::Type::OBJECT);
+  ASSERT_TRUE(__allocations - before <= 5);  /* node, bodies, vector */
+  ASSERT_TRUE(obj->at("child")->as_array()[0]->as_object().empty());
+  string text(100, 'x');
+  before = __allocations;
+  JsonStringPtr moved = make_json_string(std::move(text));
+  ASSERT_TRUE(__allocations == before && moved->to_string().size() == 100);
+  JsonStringPtr copy = make_json_string(string_view(moved->to_string()));
+  ASSERT_TRUE(__allocations == before + 1);
+}
+
+TEST(JsonObject, compact_output)
+{
+  static const char* doc =
+    R"({ "id": -12, "ratio": 0.25, "name": "a \"b\"\n", "ok": true,
+         "none": null, "empty": [ {}, [] ],
+         "nested": { "list": [ 1, 2.5e+30, "x" ] } })";
+  static const string expected =
+    R"({"id":-12,"ratio":0.25,"name":"a \"b\"\n","ok":true,"none":null,)"
+    R"("empty":[{},[]],"nested":{"list":[1,2.5e+30,"x"]}})";
+  s_config_t cfg;
+  cfg.compact = true;
+  cfg.global_indentation = 4;
+  stringstream records, tape, value;
+  write_json_text(records, make_json_record(doc), cfg);
+  write_json_text(tape, make_json_tape(doc)->root(), cfg);
+  write_json_text(value, make_json_value(doc), cfg);
+  ASSERT_TRUE(records.str() == expected);
+  ASSERT_TRUE(tape.str() == expected);
+  ASSERT_TRUE(value.str() == expected);
+
+  /* compact output reads back the same, past the size of the buffer */
+  JsonArrayPtr array = make_json_array();
+  for (int i=0; i<5000; ++i) {
+    array->push_back(make_json_string(string(i % 50, 'a' + i % 26)));
+  }
+  array->push_back(make_json_string(string(100000, 'z')));
+  stringstream pretty, compact;
+  write_json_text(pretty, array);
+  write_json_text(compact, array, cfg);
+  ASSERT_TRUE(compact.str().size() < pretty.str().size());
+  stringstream reread;
+  write_json_text(reread, make_json_record(compact.str()));
+  ASSERT_TRUE(reread.str() == pretty.str());
+}
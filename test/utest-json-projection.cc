@@ -0,0 +1,107 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+static const char* __document =
+  R"({ "user": { "id": 7, "name": "ann", "roles": [ "a", "b" ] },
+       "items": [ { "sku": "x1", "price": 2.5, "stock": [ 1, 2 ] },
+                  { "sku": "x2", "price": 4, "stock": [] },
+                  { "sku": "x3" } ],
+       "a/b": { "c~d": true }, "note": "téxt\n" })";
+
+TEST(JsonProjection, selected_paths)
+{
+  const char* expected =
+    R"({ "user": { "id": 7 },
+         "items": [ { "price": 2.5 }, { "price": 4 }, {} ] })";
+  d_config_t cfg = __projection_config({ "/user/id", "/items/*/price" });
+  JsonRecordPtr projected = make_json_record(__document, cfg);
+  ASSERT_TRUE(__serialize(projected)
+              == __serialize(make_json_record(expected)));
+
+  cfg.strict_json = true;
+  ASSERT_TRUE(__serialize(make_json_record(__document, cfg))
+              == __serialize(projected));
+
+  istringstream istrm(__document);
+  ASSERT_TRUE(__serialize(make_json_record(istrm, cfg))
+              == __serialize(projected));
+}
+
+TEST(JsonProjection, subtrees_and_indices)
+{
+  /* a leaf keeps its whole subtree, elements off the paths are dropped;
+   * ~1 and ~0 escape `/' and `~' */
+  const char* expected =
+    R"({ "user": { "id": 7, "name": "ann", "roles": [ "a", "b" ] },
+         "items": [ { "stock": [] } ], "a/b": { "c~d": true } })";
+  d_config_t cfg = __projection_config(
+                     { "/user", "/items/1/stock", "/a~1b/c~0d", "/missing" });
+  ASSERT_TRUE(__serialize(make_json_record(__document, cfg))
+              == __serialize(make_json_record(expected)));
+
+  /* the empty path stands for the whole document */
+  cfg = __projection_config({ "" });
+  ASSERT_TRUE(__serialize(make_json_record(__document, cfg))
+              == __serialize(make_json_record(__document)));
+}
+
+TEST(JsonProjection, skipped_values_are_not_parsed)
+{
+  /* the malformed values are never decoded */
+  const char* doc = R"({ "bad": [ 0x, "\q", { ,: } ], "id": 3 })";
+  JsonRecordPtr record = make_json_record(doc, __projection_config({ "/id" }));
+  ASSERT_TRUE(record->as_object().size() == 1);
+  ASSERT_TRUE(record->as_object().at("id")->as_data().as_int() == 3);
+
+  struct count_t : public JsonHandler {
+    size_t n = 0;
+    void on_string(string_view) { ++ n; }
+    void on_number(double) { ++ n; }
+  } handler;
+  parse_json_events(__document, handler,
+                    __projection_config({ "/items/*/sku" }, true));
+  ASSERT_TRUE(handler.n == 3);
+
+  bool thrown = false;
+  try { make_json_record(doc, __projection_config({ "id" })); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonProjection, strict_skipped_values_are_validated)
+{
+  /* the skipped values are left undecoded, but still held to the grammar */
+  d_config_t cfg = __projection_config({ "/id" }, true);
+  JsonRecordPtr record = make_json_record(
+    R"({ "skip": [ "é😀", { "k\n": -1.5e3, "": [ {}, [] ] },
+                   9223372036854775807, true, null ], "id": 3 })", cfg);
+  ASSERT_TRUE(__serialize(record)
+              == __serialize(make_json_record(R"({ "id": 3 })")));
+
+  const char* invalid_docs[] = {
+    R"({ "skip": "\q", "id": 3 })",
+    R"({ "skip": "\ud83d", "id": 3 })",
+    R"({ "skip": { "\x": 1 }, "id": 3 })",
+    R"({ "skip": 01, "id": 3 })",
+    R"({ "skip": [ 1. ], "id": 3 })",
+    R"({ "skip": 9223372036854775808, "id": 3 })",
+    R"({ "skip": [ 1, ], "id": 3 })",
+    R"({ "skip": { "a" 1 }, "id": 3 })",
+    R"({ "skip": [ 1 }, "id": 3 })",
+    R"({ "skip": [ tru ], "id": 3 })",
+    R"({ "skip": [ [ 1 ], "id": 3 })",
+  };
+  for (const char* doc : invalid_docs) {
+    bool thrown = false;
+    try { make_json_record(doc, cfg); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+}
@@ -0,0 +1,100 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+static JsonRecordPtr
+__parse_in_chunks(string_view doc, size_t chunk_size,
+                  const d_config_t& cfg = d_config_t())
+{
+  JsonPushParserPtr parser = make_json_push_parser(cfg);
+  for (size_t pos=0; pos<doc.size(); pos+=chunk_size) {
+    parser->feed(doc.substr(pos, chunk_size));
+  }
+  return parser->finish();
+}
+
+TEST(JsonPush, chunk_boundaries)
+{
+  /* every chunk size, so that the chunks end inside of each token */
+  const string doc = R"(// leading comment
+{ unquoted: 'single \'quoted\'', "esc": "tab\t bmp \u00e9 pair \ud83d\ude00",
+  /* block **/ "numbers": [ 0, -12.5e-3, 0x1F, +7, 123456789012 ],
+  "literals": [ true, false, null ], "nested": { "a": [ {}, [] ] } } )";
+  const string expected = __serialize(make_json_record(string_view(doc)));
+  for (size_t chunk_size=1; chunk_size<=doc.size(); ++chunk_size) {
+    ASSERT_TRUE(__serialize(__parse_in_chunks(doc, chunk_size)) == expected);
+  }
+}
+
+TEST(JsonPush, long_tokens)
+{
+  string doc = "[\"" + string(1 << 20, 'x') + "\\n\", "
+               + "0." + string(5000, '1') + "]";
+  auto record = __parse_in_chunks(doc, 1);
+  ASSERT_TRUE(record->as_array().size() == 2);
+  ASSERT_TRUE(record->as_array()[0]->as_string().to_string().size()
+              == (1 << 20) + 1);
+}
+
+TEST(JsonPush, truncated_input)
+{
+  const char* json_strs[] = {
+    R"([ 1, 2 )",
+    R"({ "key": "unterminated )",
+    R"({ "key": )",
+  };
+  for (const char* json_str : json_strs) {
+    bool thrown = false;
+    try { __parse_in_chunks(json_str, 3); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+}
+
+TEST(JsonPush, strict_json)
+{
+  d_config_t cfg;
+  cfg.strict_json = true;
+  const string doc = R"({ "a": [ 1, -2.5e-3, "x\"y \u00e9\ud83d\ude00" ],
+                          "b": null, "c": { "d": [ true, false, {}, [] ] } })";
+  const string expected = __serialize(make_json_record(string_view(doc)));
+  for (size_t chunk_size=1; chunk_size<=doc.size(); ++chunk_size) {
+    ASSERT_TRUE(__serialize(__parse_in_chunks(doc, chunk_size, cfg))
+                == expected);
+  }
+
+  /* the events of a chunk are sent before the input is complete */
+  struct count_t : public JsonHandler {
+    size_t n = 0;
+    void on_integer(long long) { ++ n; }
+  } handler;
+  JsonPushParserPtr parser = make_json_push_parser(handler, cfg);
+  parser->feed(string_view("[ 1, 2, 3"));
+  ASSERT_TRUE(handler.n == 2);
+  parser->feed(string_view(" ]"));
+  parser->finish();
+  ASSERT_TRUE(handler.n == 3);
+
+  const char* json_strs[] = {
+    "/* comment */ 1", "'single'", "{ key: 1 }", "[ 1, ]", "{ \"a\": 1, }",
+    "0x7f", "+1", "01", "1.", ".5", "[ 1 2 ]", "{ \"a\" 1 }", "[ \"a\" \"b\" ]",
+    "[ truex ]", "[ nul ]", "\"unterminated", "[ 1", "{ \"a\": [ }", "]",
+    "1 2", "\"tab\tinside\"", "\"\\'\"", "[ \"a\":1 ]", "\v1",
+    "{ \"a\": 1 \"b\": 2 }", "[ -9223372036854775809 ]",
+  };
+  for (const char* json_str : json_strs) {
+    for (size_t chunk_size : { 1, 3, 64 }) {
+      bool thrown = false;
+      try { __parse_in_chunks(json_str, chunk_size, cfg); }
+      catch (const runtime_error&) { thrown = true; }
+      if (!thrown) { cout << "accepted: " << json_str << endl; }
+      EXPECT_TRUE(thrown);
+    }
+  }
+}
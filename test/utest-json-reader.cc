@@ -0,0 +1,101 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace J5Serdes;
+using namespace std;
+
+typedef JsonReader::Token Token;
+
+TEST(JsonReader, token_sequence)
+{
+  JsonReaderPtr reader = make_json_reader(
+    R"({ "a": [ 1, 2.5, "s\"t" ], b: { c: true, "d": null } })");
+  const Token expected[] = {
+    Token::OBJECT_BEGIN, Token::KEY, Token::ARRAY_BEGIN, Token::NUMBER,
+    Token::NUMBER, Token::STRING, Token::ARRAY_END, Token::KEY,
+    Token::OBJECT_BEGIN, Token::KEY, Token::BOOL, Token::KEY,
+    Token::NULL_VALUE, Token::OBJECT_END, Token::OBJECT_END, Token::END
+  };
+  for (Token token : expected) { ASSERT_TRUE(reader->next() == token); }
+  ASSERT_TRUE(reader->next() == Token::END);
+
+  reader = make_json_reader(R"([ 1, 2.5, "s\"t", true ])");
+  reader->next();
+  ASSERT_TRUE(reader->next() == Token::NUMBER && reader->is_integer() &&
+              reader->integer_value() == 1);
+  ASSERT_TRUE(reader->next() == Token::NUMBER && !reader->is_integer() &&
+              reader->number_value() == 2.5);
+  ASSERT_TRUE(reader->next() == Token::STRING &&
+              reader->string_value() == "s\"t");
+  ASSERT_TRUE(reader->next() == Token::BOOL && reader->bool_value());
+  bool thrown = false;
+  try { reader->string_value(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonReader, selective_read)
+{
+  /* for each element of the items array, read id and skip the rest */
+  const char* doc = R"({
+    "meta": { "note": "brackets in strings ]}[{ and \"quotes\"" },
+    "items": [
+      { "tags": [ "x", { "y": [] } ], "id": 10, /* ] */ "rest": "\\" },
+      { "id": 20, "blob": [ [ [ 'single ]' ] ] ] },
+      { "skipped": {}, "id": 30 }
+    ],
+    "trailer": [ 1, 2, 3 ]
+  })";
+  JsonReaderPtr reader = make_json_reader(doc);
+  vector<long long> ids;
+  ASSERT_TRUE(reader->next() == Token::OBJECT_BEGIN);
+  while (reader->next() == Token::KEY) {
+    if (reader->key() != "items") { reader->skip_value(); continue; }
+    ASSERT_TRUE(reader->next() == Token::ARRAY_BEGIN);
+    while (reader->next() == Token::OBJECT_BEGIN) {
+      while (reader->next() == Token::KEY) {
+        if (reader->key() == "id") {
+          reader->next();
+          ids.push_back(reader->integer_value());
+        } else {
+          reader->skip_value();
+        }
+      }
+    }
+  }
+  ASSERT_TRUE(reader->token() == Token::OBJECT_END);
+  ASSERT_TRUE(reader->next() == Token::END);
+  ASSERT_TRUE(ids == vector<long long>({ 10, 20, 30 }));
+
+  /* skipping an opened container makes its end the current token */
+  reader = make_json_reader(R"([ { "a": [ 1, { } ] }, 2 ])");
+  reader->next();
+  ASSERT_TRUE(reader->next() == Token::OBJECT_BEGIN);
+  reader->skip_value();
+  ASSERT_TRUE(reader->token() == Token::OBJECT_END);
+  ASSERT_TRUE(reader->next() == Token::NUMBER);
+  ASSERT_TRUE(reader->next() == Token::ARRAY_END);
+}
+
+TEST(JsonReader, skip_long_values)
+{
+  /* nested values of every length around the 32 byte blocks scanned at once,
+   * with the close of the skipped value at every offset */
+  for (int pad=0; pad<100; ++pad) {
+    string value = "{ \"k\": [" + string(pad, ' ') + "[[1,{}]], ";
+    for (int i=0; i<pad % 7; ++i) { value += "{\"s\":\"]\\\"}\"},"; }
+    value += "/* } */ 2 ] }";
+    string doc = "[ " + value + ", " + to_string(pad) + " ]";
+    JsonReaderPtr reader = make_json_reader(doc);
+    reader->next();
+    ASSERT_TRUE(reader->next() == Token::OBJECT_BEGIN);
+    reader->skip_value();
+    ASSERT_TRUE(reader->token() == Token::OBJECT_END);
+    ASSERT_TRUE(reader->next() == Token::NUMBER &&
+                reader->integer_value() == pad);
+    ASSERT_TRUE(reader->next() == Token::ARRAY_END);
+  }
+}
@@ -0,0 +1,169 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace J5Serdes;
+using namespace std;
+
+static vector<string>
+__read_all(JsonDocumentStream& stream)
+{
+  vector<string> docs;
+  while (JsonRecordPtr record = stream.next()) {
+    docs.push_back(__serialize(record));
+  }
+  return docs;
+}
+
+static const char* __ndjson =
+  "{\"id\":1,\"tags\":[\"a\",\"b\"]}\n"
+  "\n"
+  "{\"id\":2,\"nested\":{\"x\":[1,2.5,null]}}\r\n"
+  "  [true,false]  \n"
+  "\"scalar\"\n"
+  "-12";
+
+TEST(JsonStream, ndjson)
+{
+  vector<string> expected = {
+    __serialize(make_json_record(R"({"id":1,"tags":["a","b"]})")),
+    __serialize(make_json_record(R"({"id":2,"nested":{"x":[1,2.5,null]}})")),
+    __serialize(make_json_record("[true,false]")),
+    __serialize(make_json_record("\"scalar\"")),
+    __serialize(make_json_record("-12"))
+  };
+  JsonDocumentStreamPtr stream = make_json_document_stream(__ndjson);
+  ASSERT_TRUE(__read_all(*stream) == expected);
+  ASSERT_TRUE(stream->next() == nullptr);
+
+  d_config_t cfg;
+  cfg.strict_json = true;
+  stream = make_json_document_stream(__ndjson, cfg);
+  ASSERT_TRUE(__read_all(*stream) == expected);
+
+  istringstream istrm(__ndjson);
+  stream = make_json_document_stream(istrm, cfg);
+  ASSERT_TRUE(__read_all(*stream) == expected);
+
+  char path[] = "/tmp/utest-json-stream-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  string doc(__ndjson);
+  ASSERT_TRUE(write(fd, doc.data(), doc.size())
+              == static_cast<ssize_t>(doc.size()));
+  close(fd);
+  stream = make_json_document_stream_from_file(path);
+  vector<string> from_file = __read_all(*stream);
+  unlink(path);
+  ASSERT_TRUE(from_file == expected);
+}
+
+TEST(JsonStream, concatenated_documents)
+{
+  /* json5 documents need no line breaks between them */
+  const char* docs = "{a:1}{b:[2]}[3] 'four' /* five */ 5 // six\n6";
+  vector<string> expected;
+  for (const char* d : { "{a:1}", "{b:[2]}", "[3]", "'four'", "5", "6" }) {
+    expected.push_back(__serialize(make_json_record(d)));
+  }
+  JsonDocumentStreamPtr stream = make_json_document_stream(docs);
+  ASSERT_TRUE(__read_all(*stream) == expected);
+
+  /* the same, read from an istream in chunks much smaller than the
+   * documents */
+  string large;
+  expected.clear();
+  for (int i=0; i<2000; ++i) {
+    string d = "{ \"id\": " + to_string(i) + ", \"text\": \""
+               + string(i % 97, 'x') + "\" }";
+    large += d + (i % 3 ? "\n" : " ");
+    expected.push_back(__serialize(make_json_record(d)));
+  }
+  istringstream istrm(large);
+  stream = make_json_document_stream(istrm);
+  ASSERT_TRUE(__read_all(*stream) == expected);
+
+  d_config_t cfg;
+  cfg.strict_json = true;
+  istringstream lines(string(200000, 'x').insert(0, "[\"").append("\"]\n1"));
+  stream = make_json_document_stream(lines, cfg);
+  ASSERT_TRUE(stream->next()->as_array()[0]->as_string().to_string().size()
+              == 200000);
+  ASSERT_TRUE(stream->next()->as_data().as_int() == 1);
+  ASSERT_TRUE(stream->next() == nullptr);
+}
+
+TEST(JsonStream, errors)
+{
+  /* a single document does not take trailing values */
+  bool thrown = false;
+  try { make_json_record("{a:1} {b:2}"); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+
+  /* a truncated last document */
+  JsonDocumentStreamPtr stream = make_json_document_stream("[1]\n[2,");
+  ASSERT_TRUE(stream->next() != nullptr);
+  thrown = false;
+  try { stream->next(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+
+  /* json lines hold one document per line */
+  d_config_t cfg;
+  cfg.strict_json = true;
+  stream = make_json_document_stream("[1] [2]\n", cfg);
+  thrown = false;
+  try { stream->next(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonStream, parallel_lines)
+{
+  string lines;
+  const long long count = 40000;
+  for (long long i=0; i<count; ++i) {
+    lines += "{\"id\":" + to_string(i) + ",\"pad\":\"" + string(i % 31, 'p')
+             + "\",\"a\":[1,{\"b\":null}]}\n";
+  }
+  for (bool strict : { false, true }) {
+    d_config_t cfg;
+    cfg.strict_json = strict;
+    cfg.threads = 4;
+    vector<long long> ids;
+    auto collect = [&ids](JsonRecordPtr&& record) {
+      ids.push_back(record->as_object().at("id")->as_data().as_int());
+    };
+    parse_json_lines(lines, collect, cfg);
+    ASSERT_TRUE(ids.size() == static_cast<size_t>(count));
+    for (long long i=0; i<count; ++i) { ASSERT_TRUE(ids[i] == i); }
+
+    ids.clear();
+    cfg.ordered = false;
+    parse_json_lines(lines, collect, cfg);
+    sort(ids.begin(), ids.end());
+    ASSERT_TRUE(ids.size() == static_cast<size_t>(count));
+    for (long long i=0; i<count; ++i) { ASSERT_TRUE(ids[i] == i); }
+  }
+
+  /* an error in one of the chunks reaches the caller */
+  lines.insert(lines.size() / 2, "{\"id\":\n");
+  d_config_t cfg;
+  cfg.threads = 3;
+  size_t received = 0;
+  bool thrown = false;
+  try {
+    parse_json_lines(lines, [&received](JsonRecordPtr&&) { ++received; },
+                     cfg);
+  } catch (const runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_TRUE(thrown && received < static_cast<size_t>(count));
+}
@@ -0,0 +1,151 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+TEST(JsonStrict, parity_with_json5)
+{
+  const char* json_strs[] = {
+    R"("double quoted string with escape \t")",
+    R"( -3.141592653589793238462643 )",
+    R"( [ 1.00001, [ 2, 3, 4 ], "5", "6", 7, -8, 9, "0x\"A\"", [], {} ] )",
+    R"({ "one": 1, "two": { "item1" : 0.3125, "item2" : "b\u00e9\ud83d\ude00" },
+         "three": [ "1", 2, "san", true, false, null ] })",
+  };
+  for (const char* json_str : json_strs) {
+    string_view sv(json_str);
+    ASSERT_TRUE(__serialize(make_json_record(sv, __strict_config()))
+                == __serialize(make_json_record(sv)));
+  }
+}
+
+TEST(JsonStrict, escapes_across_blocks)
+{
+  /* backslash runs and escaped quotes at every offset around the 64 byte
+   * block boundaries of the structural index. */
+  string doc = "[";
+  for (int pad=0; pad<140; ++pad) {
+    if (pad) { doc += ","; }
+    doc += "\"" + string(pad, 'x') + "\\\\\\\"\\\\\", {\"k" + to_string(pad)
+           + "\\\\\":[" + to_string(pad) + "]}";
+  }
+  doc += "]";
+  auto strict = make_json_record(doc, __strict_config());
+  ASSERT_TRUE(__serialize(strict) == __serialize(make_json_record(doc)));
+  ASSERT_TRUE(strict->as_array().size() == 280);
+  ASSERT_TRUE(strict->as_array()[2]->as_string().to_string() == "x\\\"\\");
+}
+
+TEST(JsonStrict, large_document)
+{
+  /* strings and containers straddling the indexing windows */
+  string doc = "{ \"items\": [";
+  for (int i=0; i<20000; ++i) {
+    if (i) { doc += ",\n"; }
+    doc += "{ \"id\": " + to_string(i) + ", \"name\": \"" + string(i % 97, 'n')
+           + "\" }";
+  }
+  doc += "] }";
+  auto record = make_json_record(doc, __strict_config());
+  auto& items = record->as_object().at("items")->as_array();
+  ASSERT_TRUE(items.size() == 20000);
+  ASSERT_TRUE(items[19999]->as_object().at("id")->as_data().as_int() == 19999);
+  ASSERT_TRUE(__serialize(record) == __serialize(make_json_record(doc)));
+}
+
+TEST(JsonStrict, numbers)
+{
+  auto record = make_json_record(string_view("[ 0, -0.5, 1e3, 2.5E-1, "
+                                             "9223372036854775807, "
+                                             "1.8446744073709551616e19 ]"),
+                                 __strict_config());
+  auto& array = record->as_array();
+  ASSERT_TRUE(array[0]->as_data().as_int() == 0);
+  ASSERT_TRUE(array[1]->as_data().as_double() == -0.5);
+  ASSERT_TRUE(array[2]->as_data().as_double() == 1000.);
+  ASSERT_TRUE(array[3]->as_data().as_double() == 0.25);
+  ASSERT_TRUE(array[4]->as_data().as_int() == 9223372036854775807LL);
+  ASSERT_TRUE(array[5]->as_data().as_double() == 18446744073709551616.);
+}
+
+TEST(JsonStrict, rejects_non_rfc8259_input)
+{
+  const char* json_strs[] = {
+    "/* comment */ 1", "'single'", "{ key: 1 }", "[ 1, ]", "{ \"a\": 1, }",
+    "0x7f", "+1", "01", "1.", ".5", "[ 1 2 ]", "{ \"a\" 1 }", "[ \"a\" \"b\" ]",
+    "[ truex ]", "[ nul ]", "\"unterminated", "[ 1", "{ \"a\": [ }", "]",
+    "1 2", "\"tab\tinside\"", "\"\\'\"", "[ \"a\":1 ]", "{ \"a\": 1 \"b\": 2 }",
+    "18446744073709551616", "[ -9223372036854775809 ]",
+  };
+  for (const char* json_str : json_strs) {
+    bool thrown = false;
+    try { make_json_record(string_view(json_str), __strict_config()); }
+    catch (const runtime_error& e) { thrown = true; }
+    if (!thrown) { cout << "accepted: " << json_str << endl; }
+    EXPECT_TRUE(thrown);
+  }
+  ASSERT_TRUE(make_json_record(string_view(" \n "), __strict_config())
+              == nullptr);
+}
+
+TEST(JsonStrict, istream_input)
+{
+  istringstream istrm(R"({ "a": [ 1, 2 ] })");
+  auto record = make_json_record(istrm, __strict_config());
+  ASSERT_TRUE(record->as_object().at("a")->as_array().size() == 2);
+}
+
+TEST(JsonStrict, parallel_array)
+{
+  /* strings full of brackets, commas, quotes and backslashes, which the
+   * split points must not fall into */
+  string doc = "  [";
+  for (int i=0; doc.size() < (5 << 20); ++i) {
+    if (i) { doc += ",\n"; }
+    doc += "{ \"id\": " + to_string(i) + ", \"s\": \"],[{\\\"," +
+           string(i % 7, '\\') + string(i % 7, '\\') + "\\\\\"" +
+           ", \"a\": [ " + to_string(i % 13) + ", [ \"" + string(i % 300, ',')
+           + "\" ], {} ] }";
+  }
+  doc += "]\n";
+  d_config_t cfg = __strict_config();
+  cfg.parallel = true;
+  cfg.threads = 4;
+  auto record = make_json_record(doc, cfg);
+  ASSERT_TRUE(__serialize(record)
+              == __serialize(make_json_record(doc, __strict_config())));
+
+  /* errors in any of the slices */
+  for (size_t at : { doc.size() / 8, doc.size() / 2, doc.size() / 8 * 7 }) {
+    string bad = doc;
+    bad.insert(bad.find("{ \"id\"", at), ",");
+    bool thrown = false;
+    try { make_json_record(bad, cfg); }
+    catch (const runtime_error&) { thrown = true; }
+    ASSERT_TRUE(thrown);
+  }
+
+  /* with intern_strings, the slices share one pool */
+  cfg.intern_strings = true;
+  auto interned = make_json_record(doc, cfg);
+  const JsonArray& array = interned->as_array();
+  /* the string of 40 commas in the first and last slices */
+  auto value = [&array](size_t i) {
+    return &array[i]->as_object().at("a")->as_array()[1]->as_array()[0]
+              ->as_string().to_string();
+  };
+  size_t last = (array.size() - 300) / 300 * 300 + 40;
+  ASSERT_TRUE(*value(40) == string(40, ','));
+  ASSERT_TRUE(value(40) == value(last));
+  cfg.intern_strings = false;
+
+  /* other documents are parsed as usual */
+  string object = "{ \"items\": " + doc + "}";
+  ASSERT_TRUE(make_json_record(object, cfg)->as_object().at("items")
+              ->as_array().size() == record->as_array().size());
+}
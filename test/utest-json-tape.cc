@@ -0,0 +1,141 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+TEST(JsonTape, parity_with_records)
+{
+  string expected = __serialize(make_json_record(__sample_document));
+  JsonTapePtr tape = make_json_tape(__sample_document);
+  ASSERT_TRUE(__serialize(tape->root()) == expected);
+
+  d_config_t cfg;
+  cfg.strict_json = true;
+  ASSERT_TRUE(__serialize(make_json_tape(__sample_document, cfg)->root())
+              == expected);
+  istringstream istrm(__sample_document);
+  ASSERT_TRUE(__serialize(make_json_tape(istrm)->root()) == expected);
+
+  /* json5, scalar documents, projections and indentation */
+  const char* json5 = "// comment\n{ a: 'x', b: [ 0x10, +1, .5, ], }";
+  ASSERT_TRUE(__serialize(make_json_tape(json5)->root())
+              == __serialize(make_json_record(json5)));
+  ASSERT_TRUE(__serialize(make_json_tape("\"str\"")->root()) == "\"str\"");
+  ASSERT_TRUE(__serialize(make_json_tape(" 42 ")->root()) == "42");
+  cfg.paths = { "/items/*/sku" };
+  ASSERT_TRUE(__serialize(make_json_tape(__sample_document, cfg)->root())
+              == __serialize(make_json_record(__sample_document, cfg)));
+  s_config_t s_cfg;
+  s_cfg.global_indentation = 3;
+  s_cfg.indentation_width = 4;
+  stringstream from_tape, from_record;
+  write_json_text(from_tape, tape->root().at("items"), s_cfg);
+  JsonRecordPtr record = make_json_record(__sample_document);
+  write_json_text(from_record, record->as_object().at("items"), s_cfg);
+  ASSERT_TRUE(from_tape.str() == from_record.str());
+}
+
+TEST(JsonTape, access)
+{
+  JsonTapePtr tape = make_json_tape(__sample_document);
+  JsonTapeValue root = tape->root();
+  ASSERT_TRUE(root.type() == JsonRecord::Type::OBJECT);
+  ASSERT_TRUE(root.size() == 9);
+  ASSERT_TRUE(root.at("id").as_int() == 12);
+  ASSERT_TRUE(root.at("id").type() == JsonRecord::Type::DATA);
+  ASSERT_TRUE(root.at("name").string_value()
+              == "a \"quoted\" name longer than fifteen bytes");
+  ASSERT_TRUE(root.at("ratio").as_double() == 0.25);
+  ASSERT_TRUE(root.at("ok").as_bool() && !root.at("no").as_bool());
+  ASSERT_TRUE(root.at("parent").is_null());
+  ASSERT_TRUE(root.at("parent").to_string() == "null");
+  ASSERT_TRUE(root.at("big").to_string() == "-9007199254740993");
+  ASSERT_TRUE(root.count("items") == 1 && root.count("missing") == 0);
+  ASSERT_TRUE(root.find("missing") == root.end());
+
+  JsonTapeValue tags = root.at("tags");
+  ASSERT_TRUE(tags.size() == 4);
+  ASSERT_TRUE(tags[1].empty() && tags[2].empty());
+  ASSERT_TRUE(tags[2].type() == JsonRecord::Type::OBJECT);
+  ASSERT_TRUE(tags[3][1][0].as_unsigned() == 2);
+
+  /* iteration skips nested values */
+  string keys;
+  for (auto it = root.begin(); it != root.end(); ++ it) {
+    keys += string(it.key()) + ",";
+  }
+  ASSERT_TRUE(keys == "id,name,ratio,tags,ok,no,parent,big,items,");
+  double total = 0.;
+  size_t n = 0;
+  for (JsonTapeValue item : root.at("items")) {
+    ++ n;
+    auto price = item.find("price");
+    if (price != item.end()) { total += (*price).as_double(); }
+  }
+  ASSERT_TRUE(n == 2 && total == 2.5);
+
+  bool thrown = false;
+  try { tags.at(4); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { root.at("missing"); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { root.at("id").size(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { tags.string_value(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { make_json_tape("[ 1, 2"); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonTape, compact)
+{
+  /* two words per number, one word per string and container end */
+  string doc = "[";
+  for (int i=0; i<1000; ++i) { doc += string(i ? "," : "") + to_string(i); }
+  doc += "]";
+  JsonTapePtr tape = make_json_tape(doc);
+  ASSERT_TRUE(tape->root().size() == 1000);
+  ASSERT_TRUE(tape->root()[999].as_int() == 999);
+  ASSERT_TRUE(tape->memory_usage() <= 2 * (2 * 1000 + 2) * sizeof(uint64_t));
+}
+
+TEST(JsonTape, duplicate_keys)
+{
+  /* the first one wins, as in records, with its nested values kept whole */
+  const char* doc = R"({ "a": 1, "b": [ 2 ], "a": { "x": [ 3, { "a": 4 } ] },
+                         "b": 5, "c": { "a": 6, "a": [ 7 ] } })";
+  JsonTapePtr tape = make_json_tape(doc);
+  JsonTapeValue root = tape->root();
+  ASSERT_TRUE(root.size() == 3);
+  ASSERT_TRUE(root.at("a").as_int() == 1);
+  ASSERT_TRUE(root.at("b")[0].as_int() == 2);
+  ASSERT_TRUE(root.at("c").size() == 1 && root.at("c").at("a").as_int() == 6);
+  ASSERT_TRUE(__serialize(root) == __serialize(make_json_record(doc)));
+
+  /* and past the size where keys are indexed */
+  string big = "{";
+  for (int i=0; i<100; ++i) {
+    big += "\"k" + to_string(i) + "\": " + to_string(i) + ",";
+  }
+  for (int i=0; i<100; i+=3) { big += "\"k" + to_string(i) + "\": [ -1 ],"; }
+  big += "\"last\": true }";
+  tape = make_json_tape(big);
+  ASSERT_TRUE(tape->root().size() == 101);
+  ASSERT_TRUE(tape->root().at("k99").as_int() == 99);
+  ASSERT_TRUE(tape->root().at("last").as_bool());
+  ASSERT_TRUE(__serialize(tape->root()) == __serialize(make_json_record(big)));
+}
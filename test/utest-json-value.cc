@@ -0,0 +1,142 @@
+#include "minitest.h"
+#include "j5serdes.h"
+#include "test-util.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace J5Serdes;
+using namespace std;
+
+TEST(JsonValue, parity_with_records)
+{
+  string expected = __serialize(make_json_record(__sample_document));
+  ASSERT_TRUE(__serialize(make_json_value(__sample_document)) == expected);
+
+  d_config_t cfg;
+  cfg.strict_json = true;
+  ASSERT_TRUE(__serialize(make_json_value(__sample_document, cfg)) == expected);
+  istringstream istrm(__sample_document);
+  ASSERT_TRUE(__serialize(make_json_value(istrm)) == expected);
+
+  const char* json5 = "// comment\n{ a: 'x', b: [ 0x10, +1, .5, ], }";
+  ASSERT_TRUE(__serialize(make_json_value(json5))
+              == __serialize(make_json_record(json5)));
+  ASSERT_TRUE(__serialize(make_json_value("\"str\"")) == "\"str\"");
+  cfg.paths = { "/items/*/sku" };
+  ASSERT_TRUE(__serialize(make_json_value(__sample_document, cfg))
+              == __serialize(make_json_record(__sample_document, cfg)));
+}
+
+TEST(JsonValue, access)
+{
+  ASSERT_TRUE(sizeof(JsonValue) == 16);
+  JsonValue root = make_json_value(__sample_document);
+  ASSERT_TRUE(root.type() == JsonRecord::Type::OBJECT);
+  ASSERT_TRUE(root.size() == 9);
+  ASSERT_TRUE(root.at("id").as_int() == 12);
+  ASSERT_TRUE(root.at("id").type() == JsonRecord::Type::DATA);
+  ASSERT_TRUE(root.at("name").string_value()
+              == "a \"quoted\" name longer than fifteen bytes");
+  ASSERT_TRUE(root.at("ratio").as_double() == 0.25);
+  ASSERT_TRUE(root.at("ok").as_bool() && !root.at("no").as_bool());
+  ASSERT_TRUE(root.at("parent").is_null());
+  ASSERT_TRUE(root.at("big").to_string() == "-9007199254740993");
+  ASSERT_TRUE(root.count("items") == 1 && root.count("missing") == 0);
+  ASSERT_TRUE(root.at("tags")[3][1][0].as_unsigned() == 2);
+  ASSERT_TRUE(root.at("tags")[1].empty() && root.at("tags")[2].empty());
+
+  bool thrown = false;
+  try { root.at("tags").at(4); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { root.at("missing"); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { root.at("id").as_array(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+  thrown = false;
+  try { root.at("tags").string_value(); }
+  catch (const runtime_error&) { thrown = true; }
+  ASSERT_TRUE(thrown);
+}
+
+TEST(JsonValue, modify)
+{
+  JsonValue root(JsonRecord::Type::OBJECT);
+  root["short"] = "fifteen bytes!!";
+  root["long"] = "sixteen bytes!!!";
+  root["n"] = 3;
+  root["list"] = JsonValue(JsonRecord::Type::ARRAY);
+  for (int i=0; i<100; ++i) { root["list"].as_array().push_back(i * 0.5); }
+  root["n"] = false;
+  ASSERT_TRUE(root.size() == 4);
+  ASSERT_TRUE(root.at("short").string_value() == "fifteen bytes!!");
+  ASSERT_TRUE(root.at("long").string_value() == "sixteen bytes!!!");
+  ASSERT_TRUE(root.at("list")[99].as_double() == 49.5);
+
+  /* copies are deep, moves leave null behind */
+  JsonValue copy = root;
+  root.erase("long");
+  root.at("list").as_array().clear();
+  ASSERT_TRUE(copy.size() == 4 && copy.at("list").size() == 100);
+  ASSERT_TRUE(copy.at("long").string_value() == "sixteen bytes!!!");
+  JsonValue moved = std::move(copy);
+  ASSERT_TRUE(copy.is_null() && moved.size() == 4);
+  moved = moved.at("list");
+  ASSERT_TRUE(moved.size() == 100);
+
+  ASSERT_TRUE(__serialize(root)
+              == __serialize(make_json_record(
+                   R"({ "short": "fifteen bytes!!", "n": false,
+                        "list": [] })")));
+  ASSERT_TRUE(JsonValue("").string_value().empty());
+  ASSERT_TRUE(JsonValue(JsonRecord::Type::STRING).string_value().empty());
+  ASSERT_TRUE(JsonValue(JsonRecord::Type::DATA).is_null());
+}
+
+TEST(JsonValue, deep_nesting)
+{
+  /* freed without recursion */
+  const size_t depth = 1000000;
+  string doc = string(depth, '[') + string(depth, ']');
+  JsonValue value = make_json_value(doc);
+  size_t n = 0;
+  for (const JsonValue* v = &value; !v->empty(); v = &(*v)[0]) { ++ n; }
+  ASSERT_TRUE(n == depth - 1);
+
+  /* and copied without recursion either */
+  JsonValue copy = value;
+  value = JsonValue();
+  n = 0;
+  for (const JsonValue* v = &copy; !v->empty(); v = &(*v)[0]) { ++ n; }
+  ASSERT_TRUE(n == depth - 1);
+}
+
+TEST(JsonValue, duplicate_keys)
+{
+  /* the first one wins, as in records */
+  const char* doc = R"({ "a": 1, "b": [ 2 ], "a": { "x": [ 3 ] }, "b": 5,
+                         "c": { "a": 6, "a": [ 7 ] } })";
+  JsonValue value = make_json_value(doc);
+  ASSERT_TRUE(value.size() == 3);
+  ASSERT_TRUE(value.at("a").as_int() == 1);
+  ASSERT_TRUE(value.at("b")[0].as_int() == 2);
+  ASSERT_TRUE(value.at("c").size() == 1 && value.at("c").at("a").as_int() == 6);
+  ASSERT_TRUE(__serialize(value) == __serialize(make_json_record(doc)));
+
+  /* and past the size where keys are put in a set */
+  string big = "{";
+  for (int i=0; i<100; ++i) {
+    big += "\"k" + to_string(i) + "\": " + to_string(i) + ",";
+  }
+  for (int i=0; i<100; i+=3) { big += "\"k" + to_string(i) + "\": [ -1 ],"; }
+  big += "\"last\": true }";
+  value = make_json_value(big);
+  ASSERT_TRUE(value.size() == 101);
+  ASSERT_TRUE(value.at("k99").as_int() == 99 && value.at("last").as_bool());
+  ASSERT_TRUE(__serialize(value) == __serialize(make_json_record(big)));
+}